@@ -0,0 +1,303 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Runs audio files through CAudioPluginAudioProcessor without a host.
+
+        BatchProcessor [--state <file>] [--out <dir>] [--suffix <text>]
+                       [--jobs <n>] [--block <samples>] <files...>
+
+    --state takes either a blob saved by getStateInformation(), or a preset:
+    the plugin state as XML.
+    Files are streamed through the processor one block at a time, so memory
+    use doesn't depend on the file length. Every job thread owns its own
+    processor instance and takes the next file from a shared list.
+    The processor runs non-realtime, i.e. with its offline profile.
+    Output is written next to the input (or to --out) in the same format,
+    with the latency compensated so it lines up with the input.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+    constexpr int defaultBlockSize = 4096;
+
+    struct Options
+    {
+        juce::MemoryBlock state;
+        juce::File outputDirectory;
+        juce::String suffix = "_processed";
+        int numJobs = 1;
+        int blockSize = defaultBlockSize;
+        juce::Array<juce::File> inputFiles;
+    };
+
+    struct FileResult
+    {
+        bool ok = false;
+        juce::String message;
+        double audioSeconds = 0.0;
+        double processingSeconds = 0.0;
+    };
+
+    void printUsage()
+    {
+        std::cout << "usage: BatchProcessor [--state <file>] [--out <dir>] [--suffix <text>] [--jobs <n>] [--block <samples>] <files...>\n";
+    }
+
+    // a state blob is used as it is. a preset (XML) is turned into the same blob getStateInformation() writes.
+    bool loadState(const juce::File& file, juce::MemoryBlock& state)
+    {
+        if (auto xml = juce::parseXML(file))
+        {
+            auto tree = juce::ValueTree::fromXml(*xml);
+            if (! tree.isValid())
+                return false;
+
+            juce::MemoryOutputStream mos(state, false);
+            tree.writeToStream(mos);
+            return true;
+        }
+
+        return file.loadFileAsData(state) && state.getSize() > 0;
+    }
+
+    bool parseOptions(const juce::ArgumentList& args, Options& options)
+    {
+        for (int i = 0; i < args.size(); ++i)
+        {
+            const auto& arg = args[i];
+            auto nextValue = [&]() { return i + 1 < args.size() ? args[++i].text : juce::String(); };
+
+            if (arg == "--state")
+            {
+                auto file = juce::File::getCurrentWorkingDirectory().getChildFile(nextValue());
+                if (! loadState(file, options.state))
+                {
+                    std::cerr << "couldn't read state from " << file.getFullPathName() << "\n";
+                    return false;
+                }
+            }
+            else if (arg == "--out")
+            {
+                options.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(nextValue());
+            }
+            else if (arg == "--suffix")
+            {
+                options.suffix = nextValue();
+            }
+            else if (arg == "--jobs")
+            {
+                options.numJobs = juce::jlimit(1, 256, nextValue().getIntValue());
+            }
+            else if (arg == "--block")
+            {
+                options.blockSize = juce::jlimit(32, 65536, nextValue().getIntValue());
+            }
+            else if (arg.isLongOption() || arg.isShortOption())
+            {
+                std::cerr << "unknown option " << arg.text << "\n";
+                return false;
+            }
+            else
+            {
+                options.inputFiles.add(arg.resolveAsFile());
+            }
+        }
+
+        return ! options.inputFiles.isEmpty();
+    }
+
+    /*
+        one job thread. it keeps one processor and one block buffer for every file it handles,
+        so memory use is the same for a 1 second file and a 1 hour file.
+    */
+    struct FileWorker : juce::Thread
+    {
+        FileWorker(const Options& optionsToUse, juce::AudioFormatManager& formats,
+                   std::atomic<int>& nextFileIndex, std::vector<FileResult>& resultsToFill)
+            : juce::Thread("BatchProcessor job"),
+              options(optionsToUse),
+              formatManager(formats),
+              nextFile(nextFileIndex),
+              results(resultsToFill)
+        {
+            if (options.state.getSize() > 0)
+                processor.setStateInformation(options.state.getData(), static_cast<int>(options.state.getSize()));
+
+            //files are already spread over the cores, one instance per job. the shared pool's workers would only compete with them.
+            processor.setOfflineWorkerPoolEnabled(false);
+            processor.setNonRealtime(true);
+        }
+
+        void run() override
+        {
+            for (auto index = nextFile.fetch_add(1); index < options.inputFiles.size(); index = nextFile.fetch_add(1))
+            {
+                const auto start = std::chrono::steady_clock::now();
+                auto& result = results[static_cast<size_t>(index)];
+
+                result = processFile(options.inputFiles.getReference(index));
+                result.processingSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }
+        }
+
+        FileResult processFile(const juce::File& input)
+        {
+            FileResult result;
+
+            std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(input));
+            if (reader == nullptr)
+            {
+                result.message = "can't read " + input.getFullPathName();
+                return result;
+            }
+
+            auto* format = formatManager.findFormatForFileExtension(input.getFileExtension());
+            auto outputDirectory = options.outputDirectory == juce::File() ? input.getParentDirectory() : options.outputDirectory;
+            auto output = outputDirectory.getChildFile(input.getFileNameWithoutExtension() + options.suffix + input.getFileExtension());
+            outputDirectory.createDirectory();
+            output.deleteFile();
+
+            std::unique_ptr<juce::OutputStream> stream(output.createOutputStream());
+            if (format == nullptr || stream == nullptr)
+            {
+                result.message = "can't write " + output.getFullPathName();
+                return result;
+            }
+
+            const auto numChannels = static_cast<int>(reader->numChannels);
+            std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), reader->sampleRate,
+                                                                                    reader->numChannels,
+                                                                                    static_cast<int>(reader->bitsPerSample),
+                                                                                    reader->metadataValues, 0));
+            if (writer == nullptr)
+            {
+                result.message = "the " + format->getFormatName() + " writer doesn't support this file's format";
+                return result;
+            }
+
+            //the writer owns the stream now
+            stream.release();
+
+            processor.setPlayConfigDetails(numChannels, numChannels, reader->sampleRate, options.blockSize);
+            processor.prepareToPlay(reader->sampleRate, options.blockSize);
+
+            /*
+                the first 'latency' output samples are dropped, and the same number of zeros is pushed through after the input,
+                so the output lines up with the input and has the same length.
+            */
+            const auto latency = static_cast<juce::int64>(processor.getLatencySamples());
+            const auto inputLength = reader->lengthInSamples;
+
+            buffer.setSize(numChannels, options.blockSize, false, false, true);
+
+            juce::int64 readPosition = 0, samplesToSkip = latency, samplesWritten = 0;
+            while (samplesWritten < inputLength)
+            {
+                const auto numSamples = static_cast<int>(juce::jmin(static_cast<juce::int64>(options.blockSize), inputLength + latency - readPosition));
+                buffer.setSize(numChannels, numSamples, false, false, true);
+
+                //reading past the end of the file fills with zeros
+                reader->read(&buffer, 0, numSamples, readPosition, true, true);
+                readPosition += numSamples;
+
+                processor.processBlock(buffer, midi);
+
+                const auto skip = static_cast<int>(juce::jmin(samplesToSkip, static_cast<juce::int64>(numSamples)));
+                samplesToSkip -= skip;
+
+                const auto numToWrite = static_cast<int>(juce::jmin(static_cast<juce::int64>(numSamples - skip), inputLength - samplesWritten));
+                if (numToWrite > 0 && ! writer->writeFromAudioSampleBuffer(buffer, skip, numToWrite))
+                {
+                    result.message = "write failed for " + output.getFullPathName();
+                    return result;
+                }
+
+                samplesWritten += numToWrite;
+            }
+
+            processor.releaseResources();
+
+            result.ok = true;
+            result.message = output.getFullPathName();
+            result.audioSeconds = static_cast<double>(inputLength) / reader->sampleRate;
+            return result;
+        }
+
+        const Options& options;
+        juce::AudioFormatManager& formatManager;
+        std::atomic<int>& nextFile;
+        std::vector<FileResult>& results;
+
+        CAudioPluginAudioProcessor processor;
+        juce::AudioBuffer<float> buffer;
+        juce::MidiBuffer midi;
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    //the processor's parameter tree and async updates need a message manager, even without a message loop.
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    Options options;
+    if (! parseOptions(juce::ArgumentList(argc, argv), options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::atomic<int> nextFileIndex{ 0 };
+    std::vector<FileResult> results(static_cast<size_t>(options.inputFiles.size()));
+
+    //the processors are created here, on the message thread
+    std::vector<std::unique_ptr<FileWorker>> workers;
+    const auto numJobs = juce::jmin(options.numJobs, options.inputFiles.size());
+    for (int i = 0; i < numJobs; ++i)
+        workers.push_back(std::make_unique<FileWorker>(options, formatManager, nextFileIndex, results));
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (auto& worker : workers)
+        worker->startThread();
+
+    for (auto& worker : workers)
+        worker->waitForThreadToExit(-1);
+
+    const auto wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double totalAudioSeconds = 0.0;
+    int numFailed = 0;
+
+    std::cout << "file\taudio s\tprocessing s\tx realtime\n";
+    for (const auto& result : results)
+    {
+        if (! result.ok)
+        {
+            std::cerr << "error: " << result.message << "\n";
+            ++numFailed;
+            continue;
+        }
+
+        totalAudioSeconds += result.audioSeconds;
+        std::cout << result.message << "\t" << result.audioSeconds << "\t" << result.processingSeconds
+                  << "\t" << result.audioSeconds / juce::jmax(result.processingSeconds, 1.0e-9) << "\n";
+    }
+
+    std::cout << "total\t" << totalAudioSeconds << "\t" << wallSeconds
+              << "\t" << totalAudioSeconds / juce::jmax(wallSeconds, 1.0e-9) << "\n";
+
+    return numFailed == 0 ? 0 : 1;
+}
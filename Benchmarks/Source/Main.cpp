@@ -0,0 +1,482 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Measures the per-sample cost of the plugin, from one stage up to the
+    whole processBlock:
+        stage/<stage>/<float|double>        one DSP_Choice, every other stage bypassed
+        order/<order>/<kernel|runtime>      the whole chain, for every DSP_Order
+        smoothers/updateSmoothersFromParams once per sub-block
+        chain/updateDSPFromParams           once per sub-block, while the general filter is swept
+        kernel/<kernel>/<instruction set>   VectorKernels, for every set this CPU runs
+        processBlock/<rate>/<block size>    44.1k to 192k, 16 to 4096 samples
+    Every result is in ns per sample. The per-sub-block helpers are divided
+    by the sub-block size.
+
+    It also reports the heap each plugin instance holds after prepareToPlay,
+    with every stage, no stage and each stage on its own switched on:
+        footprint/<stages>                  bytes per instance
+    The heap is only measured where the allocator can report it (glibc and
+    macOS); elsewhere the footprints are left out.
+
+        Benchmarks [--json]
+
+    --json prints the results as JSON instead of a table, so two runs can be
+    compared by a script.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/DSP/VectorKernels.h"
+
+#include <chrono>
+#include <iostream>
+
+#if JUCE_LINUX && defined(__GLIBC__)
+ #include <malloc.h>
+#elif JUCE_MAC
+ #include <malloc/malloc.h>
+#endif
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int subBlockSize = 64; // processBlock hands the chain 64-sample sub-blocks
+    constexpr int numChannels = 2;
+
+    //every measurement covers about this many samples, whatever its block size
+    constexpr int samplesPerMeasurement = 1 << 18;
+    constexpr int minIterations = 32;
+
+    struct Result
+    {
+        juce::String name;
+        double nsPerSample = 0.0;
+        int numIterations = 0;
+        int blockSize = subBlockSize;
+        double sampleRate = ::sampleRate;
+    };
+
+    struct Footprint
+    {
+        juce::String name;
+        juce::int64 bytesPerInstance = 0;
+    };
+
+    // heap bytes the whole process has allocated, or -1 if the allocator can't tell.
+    juce::int64 getHeapBytesInUse()
+    {
+       #if JUCE_LINUX && defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+        return static_cast<juce::int64>(mallinfo2().uordblks);
+       #elif JUCE_LINUX && defined(__GLIBC__)
+        return static_cast<juce::int64>(mallinfo().uordblks);
+       #elif JUCE_MAC
+        malloc_statistics_t statistics;
+        malloc_zone_statistics(nullptr, &statistics);
+        return static_cast<juce::int64>(statistics.size_in_use);
+       #else
+        return -1;
+       #endif
+    }
+
+    // the defaults from CAudioPluginAudioProcessor::createParameterLayout()
+    DSPParameters makeDefaultParameters()
+    {
+        DSPParameters params;
+
+        params.phaserRateHz = 0.2f;
+        params.phaserCenterFreqHz = 1000.f;
+        params.phaserDepthPercent = 5.f;
+        params.phaserFeedbackPercent = 0.f;
+        params.phaserMixPercent = 5.f;
+
+        params.chorusRateHz = 0.2f;
+        params.chorusDepthPercent = 5.f;
+        params.chorusCenterDelayMs = 7.f;
+        params.chorusFeedbackPercent = 0.f;
+        params.chorusMixPercent = 5.f;
+
+        params.overdriveSaturation = 1.f;
+
+        params.ladderFilterMode = juce::dsp::LadderFilterMode::LPF12;
+        params.ladderFilterCutoffHz = 20000.f;
+        params.ladderFilterResonancePercent = 0.f;
+        params.ladderFilterDrive = 1.f;
+
+        params.generalFilterMode = GeneralFilterMode::Peak;
+        params.generalFilterFreqHz = 750.f;
+        params.generalFilterQuality = 0.72f;
+        params.generalFilterGainDb = 0.f;
+
+        params.delayTimeMs = 250.f;
+        params.delayFeedbackPercent = 35.f;
+        params.delayLowCutHz = 80.f;
+        params.delayHighCutHz = 8000.f;
+        params.delayModulationRateHz = 0.5f;
+        params.delayModulationDepthMs = 1.f;
+        params.delayMixPercent = 25.f;
+
+        return params;
+    }
+
+    const char* getOptionName(DSP_Option option)
+    {
+        static const char* names[] = { "PHS", "CHO", "OVD", "LAD", "GEN", "DLY" };
+        return names[static_cast<size_t>(option)];
+    }
+
+    juce::String getOrderName(const DSP_Order& order)
+    {
+        juce::StringArray parts;
+        for (auto option : order)
+            parts.add(getOptionName(option));
+
+        return parts.joinIntoString(">");
+    }
+
+    int getNumIterations(int blockSize)
+    {
+        return juce::jmax(minIterations, samplesPerMeasurement / blockSize);
+    }
+
+    // calls fn() numIterations times after a warm up, returns ns per call.
+    template<typename Fn>
+    double measureNsPerCall(int numIterations, Fn&& fn)
+    {
+        //warm up caches and branch predictors
+        for (int n = 0; n < numIterations / 10; ++n)
+            fn();
+
+        auto start = std::chrono::steady_clock::now();
+        for (int n = 0; n < numIterations; ++n)
+            fn();
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        return elapsed / static_cast<double>(numIterations);
+    }
+
+    // process() gets a fresh copy of the same noise every time.
+    template<typename SampleType, typename ProcessFn>
+    Result measureBlocks(const juce::String& name, int blockSize, ProcessFn&& process)
+    {
+        juce::AudioBuffer<SampleType> input(numChannels, blockSize), work(numChannels, blockSize);
+
+        juce::Random random(0x5eed);
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < blockSize; ++i)
+                input.setSample(ch, i, static_cast<SampleType>(random.nextFloat() * 2.f - 1.f));
+
+        Result result;
+        result.name = name;
+        result.blockSize = blockSize;
+        result.numIterations = getNumIterations(blockSize);
+
+        auto nsPerBlock = measureNsPerCall(result.numIterations, [&]()
+        {
+            work.makeCopyOf(input, true);
+            process(work);
+        });
+
+        result.nsPerSample = nsPerBlock / blockSize;
+        return result;
+    }
+
+    // the chain with every stage but 'option' bypassed.
+    template<typename SampleType>
+    Result measureStage(DSP_Option option, DSPParameters params, const juce::dsp::ProcessSpec& spec)
+    {
+        for (size_t i = 0; i < params.bypassed.size(); ++i)
+            params.bypassed[i] = i != static_cast<size_t>(option);
+
+        const auto order = getDSPOrderFromIndex(0);
+
+        MultiChannelDSP<SampleType> chain;
+        chain.prepare(spec, params.bypassed);
+        chain.updateDSPFromParams(params);
+
+        const auto name = juce::String("stage/") + getOptionName(option) + (std::is_same_v<SampleType, float> ? "/float" : "/double");
+
+        //only 'option' is prepared, the other stages start out fully bypassed.
+        return measureBlocks<SampleType>(name, subBlockSize, [&](juce::AudioBuffer<SampleType>& buffer)
+        {
+            chain.process(juce::dsp::AudioBlock<SampleType>(buffer), order, params);
+        });
+    }
+
+    void benchmarkStages(std::vector<Result>& results, const DSPParameters& params, const juce::dsp::ProcessSpec& spec)
+    {
+        for (size_t i = 0; i < static_cast<size_t>(DSP_Option::END_OF_LIST); ++i)
+        {
+            const auto option = static_cast<DSP_Option>(i);
+            results.push_back(measureStage<float>(option, params, spec));
+            results.push_back(measureStage<double>(option, params, spec));
+        }
+    }
+
+    // every DSP_Order, through its pre-generated kernel and through the runtime-dispatched path.
+    void benchmarkOrders(std::vector<Result>& results, const DSPParameters& params, const juce::dsp::ProcessSpec& spec)
+    {
+        MultiChannelDSP<float> chain;
+
+        for (size_t index = 0; index < NumDSPOrders; ++index)
+        {
+            const auto order = getDSPOrderFromIndex(index);
+            const auto name = "order/" + getOrderName(order);
+
+            chain.prepare(spec, params.bypassed);
+            chain.updateDSPFromParams(params);
+            results.push_back(measureBlocks<float>(name + "/kernel", subBlockSize, [&](juce::AudioBuffer<float>& buffer)
+            {
+                chain.process(juce::dsp::AudioBlock<float>(buffer), order, params);
+            }));
+
+            chain.prepare(spec, params.bypassed);
+            chain.updateDSPFromParams(params);
+            results.push_back(measureBlocks<float>(name + "/runtime", subBlockSize, [&](juce::AudioBuffer<float>& buffer)
+            {
+                chain.processWithRuntimeOrder(juce::dsp::AudioBlock<float>(buffer), order, params);
+            }));
+        }
+    }
+
+    // the general filter is swept over 200Hz - 5kHz, so every call rebuilds its coefficients.
+    void benchmarkChainUpdate(std::vector<Result>& results, DSPParameters params, const juce::dsp::ProcessSpec& spec)
+    {
+        MultiChannelDSP<float> chain;
+        chain.prepare(spec, params.bypassed);
+
+        int step = 0;
+        Result result;
+        result.name = "chain/updateDSPFromParams";
+        result.numIterations = getNumIterations(subBlockSize);
+        result.nsPerSample = measureNsPerCall(result.numIterations, [&]()
+        {
+            params.generalFilterFreqHz = 200.f + static_cast<float>(step++ % 480) * 10.f;
+            chain.updateDSPFromParams(params);
+        }) / subBlockSize;
+
+        results.push_back(result);
+    }
+
+    // at the sub-block size the 8x oversampled overdrive shapes.
+    void benchmarkVectorKernels(std::vector<Result>& results)
+    {
+        constexpr int blockSize = subBlockSize * 8;
+
+        for (int i = 0; i < static_cast<int>(InstructionSet::END_OF_LIST); ++i)
+        {
+            const auto set = static_cast<InstructionSet>(i);
+            const auto* kernels = VectorKernels<float>::get(set);
+            if (kernels == nullptr)
+                continue;
+
+            const auto setName = juce::String(getInstructionSetName(set));
+            std::vector<float> gains(blockSize, 0.5f);
+
+            results.push_back(measureBlocks<float>("kernel/shape/" + setName, blockSize, [&](juce::AudioBuffer<float>& buffer)
+            {
+                for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                    kernels->shape(buffer.getWritePointer(ch), blockSize, 1.5f, 0.001f, 0.8f, -0.0001f);
+            }));
+
+            results.push_back(measureBlocks<float>("kernel/mix/" + setName, blockSize, [&](juce::AudioBuffer<float>& buffer)
+            {
+                for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                    kernels->mix(buffer.getWritePointer(ch), buffer.getReadPointer(ch), gains.data(), gains.data(), blockSize);
+            }));
+        }
+    }
+
+    void printTable(const std::vector<Result>& results, const std::vector<Footprint>& footprints)
+    {
+        std::cout << "benchmark\tns/sample\titerations\n";
+        for (const auto& result : results)
+            std::cout << result.name << "\t" << result.nsPerSample << "\t" << result.numIterations << "\n";
+
+        if (footprints.empty())
+            return;
+
+        std::cout << "\nfootprint\tbytes/instance\n";
+        for (const auto& footprint : footprints)
+            std::cout << footprint.name << "\t" << footprint.bytesPerInstance << "\n";
+    }
+
+    void printJson(const std::vector<Result>& results, const std::vector<Footprint>& footprints)
+    {
+        auto* context = new juce::DynamicObject();
+        context->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+        context->setProperty("cpu", juce::SystemStats::getCpuModel());
+        context->setProperty("num_cpus", juce::SystemStats::getNumCpus());
+        context->setProperty("instruction_set", getInstructionSetName(getBestInstructionSet()));
+       #if JUCE_DEBUG
+        context->setProperty("build_type", "debug");
+       #else
+        context->setProperty("build_type", "release");
+       #endif
+
+        juce::Array<juce::var> benchmarks;
+        for (const auto& result : results)
+        {
+            auto* entry = new juce::DynamicObject();
+            entry->setProperty("name", result.name);
+            entry->setProperty("ns_per_sample", result.nsPerSample);
+            entry->setProperty("iterations", result.numIterations);
+            entry->setProperty("block_size", result.blockSize);
+            entry->setProperty("sample_rate", result.sampleRate);
+            benchmarks.add(juce::var(entry));
+        }
+
+        juce::Array<juce::var> footprintEntries;
+        for (const auto& footprint : footprints)
+        {
+            auto* entry = new juce::DynamicObject();
+            entry->setProperty("name", footprint.name);
+            entry->setProperty("bytes_per_instance", footprint.bytesPerInstance);
+            footprintEntries.add(juce::var(entry));
+        }
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty("context", juce::var(context));
+        root->setProperty("benchmarks", benchmarks);
+        root->setProperty("footprints", footprintEntries);
+
+        std::cout << juce::JSON::toString(juce::var(root)) << "\n";
+    }
+}
+
+// a friend of CAudioPluginAudioProcessor, so it can time the helpers processBlock() calls once per sub-block.
+struct ProcessorBenchmarks
+{
+    static void benchmarkSmootherUpdate(std::vector<Result>& results)
+    {
+        CAudioPluginAudioProcessor processor;
+        processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, subBlockSize);
+        processor.prepareToPlay(sampleRate, subBlockSize);
+
+        Result result;
+        result.name = "smoothers/updateSmoothersFromParams";
+        result.numIterations = getNumIterations(subBlockSize);
+        result.nsPerSample = measureNsPerCall(result.numIterations, [&]()
+        {
+            processor.updateSmoothersFromParams(subBlockSize, CAudioPluginAudioProcessor::SmootherUpdateMode::liveInRealtime);
+        }) / subBlockSize;
+
+        results.push_back(result);
+        processor.releaseResources();
+    }
+
+    static void benchmarkProcessBlock(std::vector<Result>& results)
+    {
+        static constexpr double sampleRates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+
+        CAudioPluginAudioProcessor processor;
+        juce::MidiBuffer midi;
+
+        for (auto rate : sampleRates)
+        {
+            for (int blockSize = 16; blockSize <= 4096; blockSize *= 2)
+            {
+                processor.setPlayConfigDetails(numChannels, numChannels, rate, blockSize);
+                processor.prepareToPlay(rate, blockSize);
+
+                const auto name = "processBlock/" + juce::String(juce::roundToInt(rate)) + "/" + juce::String(blockSize);
+                auto result = measureBlocks<float>(name, blockSize, [&](juce::AudioBuffer<float>& buffer)
+                {
+                    processor.processBlock(buffer, midi);
+                });
+
+                result.sampleRate = rate;
+                results.push_back(result);
+
+                processor.releaseResources();
+            }
+        }
+    }
+
+    /*
+        the heap a batch of instances holds after prepareToPlay, divided by the batch size.
+        a batch averages out the allocator's own bookkeeping.
+    */
+    static Footprint measureFootprint(const juce::String& name, const DSP_Bypassed& bypassed)
+    {
+        constexpr int numInstances = 16;
+        constexpr int blockSize = 512;
+
+        const auto heapBefore = getHeapBytesInUse();
+
+        std::vector<std::unique_ptr<CAudioPluginAudioProcessor>> processors;
+        for (int i = 0; i < numInstances; ++i)
+        {
+            auto& processor = *processors.emplace_back(std::make_unique<CAudioPluginAudioProcessor>());
+
+            const std::array<juce::AudioParameterBool*, static_cast<size_t>(DSP_Option::END_OF_LIST)> bypassParams
+            {
+                processor.phaserBypass, processor.chorusBypass, processor.overdriveBypass, processor.ladderFilterBypass, processor.generalFilterBypass,
+                processor.delayBypass
+            };
+
+            for (size_t stage = 0; stage < bypassParams.size(); ++stage)
+                bypassParams[stage]->setValueNotifyingHost(bypassed[stage] ? 1.f : 0.f);
+
+            processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+            processor.prepareToPlay(sampleRate, blockSize);
+        }
+
+        Footprint footprint;
+        footprint.name = name;
+        footprint.bytesPerInstance = (getHeapBytesInUse() - heapBefore) / numInstances;
+        return footprint;
+    }
+
+    static void benchmarkFootprints(std::vector<Footprint>& footprints)
+    {
+        if (getHeapBytesInUse() < 0)
+            return;
+
+        DSP_Bypassed allBypassed;
+        allBypassed.fill(true);
+
+        footprints.push_back(measureFootprint("footprint/all", {}));
+        footprints.push_back(measureFootprint("footprint/none", allBypassed));
+
+        for (size_t i = 0; i < allBypassed.size(); ++i)
+        {
+            auto bypassed = allBypassed;
+            bypassed[i] = false;
+            footprints.push_back(measureFootprint(juce::String("footprint/") + getOptionName(static_cast<DSP_Option>(i)), bypassed));
+        }
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    //the processor's parameter tree needs a message manager, even without a message loop.
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ScopedNoDenormals noDenormals;
+
+    const auto asJson = juce::ArgumentList(argc, argv).containsOption("--json");
+
+    const auto params = makeDefaultParameters();
+    const auto spec = juce::dsp::ProcessSpec{ sampleRate, static_cast<juce::uint32>(subBlockSize), static_cast<juce::uint32>(numChannels) };
+
+    std::vector<Result> results;
+    std::vector<Footprint> footprints;
+
+    benchmarkStages(results, params, spec);
+    benchmarkOrders(results, params, spec);
+    ProcessorBenchmarks::benchmarkSmootherUpdate(results);
+    benchmarkChainUpdate(results, params, spec);
+    benchmarkVectorKernels(results);
+    ProcessorBenchmarks::benchmarkProcessBlock(results);
+    ProcessorBenchmarks::benchmarkFootprints(footprints);
+
+    if (asJson)
+        printJson(results, footprints);
+    else
+        printTable(results, footprints);
+
+    return 0;
+}
@@ -0,0 +1,537 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Runs CAudioPluginAudioProcessor::processBlock on a simulated host audio
+    thread and fails if that thread allocates, frees, locks, waits, sleeps,
+    touches a file (see RealtimeInterceptors.h) or gets stuck in a callback.
+
+        RealtimeAudit [--seconds <per scenario>] [--block <samples>] [--rate <hz>]
+                      [--deadline <ms>] [--suppressions <file>]
+                      [--no-default-suppressions] [--no-editor] [--abort]
+
+    The audio thread runs for the whole audit, every callback inside an
+    AllocationTracker::ScopedRealtimeSection, while these scenarios run one
+    after the other:
+        steady       nothing but processBlock
+        automation   the audio thread automates every parameter, the way plugin wrappers do
+        reorder      the message thread pushes random orders into dspOrderFifo
+        state        the message thread restores two different states in turn, racing the audio thread
+        editor       the message thread opens and closes the editor
+    Block sizes vary from callback to callback, up to --block.
+    A callback that takes longer than --deadline ms (default: 20 times its
+    block length) is reported as a possible unbounded loop.
+
+    Each distinct call stack is reported once, symbolized by addr2line, so
+    build with debug info (Debug or RelWithDebInfo). A suppressions file has
+    one function name per line. A violation is suppressed when one of them is
+    on its stack before any of the plugin's own frames, i.e. when the call
+    comes from code the plugin calls into but doesn't own.
+    --abort stops at the first violation instead, for a debugger.
+    Exit code 1 if anything was found that isn't suppressed.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/Diagnostics/AllocationTracker.h"
+#include "RealtimeInterceptors.h"
+
+#include <iostream>
+
+namespace
+{
+    constexpr int numChannels = 2;
+    constexpr int tickMs = 10;
+    constexpr int editorToggleTicks = 25;
+    constexpr int numParametersPerCallback = 4;
+
+    /*
+        every JUCE plugin wrapper calls these from the audio thread for host automation.
+        they take JUCE's listener locks before the plugin's parameterChanged() runs.
+    */
+    const char* const defaultSuppressions[] =
+    {
+        "juce::AudioProcessorParameter::sendValueChangedMessageToListeners",
+        "juce::AudioProcessorValueTreeState::ParameterAdapter::parameterValueChanged",
+    };
+
+    enum class Scenario
+    {
+        Steady,
+        Automation,
+        Reorder,
+        State,
+        Editor,
+        END_OF_LIST
+    };
+
+    const char* getScenarioName(Scenario scenario)
+    {
+        switch (scenario)
+        {
+            case Scenario::Steady: return "steady";
+            case Scenario::Automation: return "automation";
+            case Scenario::Reorder: return "reorder";
+            case Scenario::State: return "state";
+            case Scenario::Editor: return "editor";
+            case Scenario::END_OF_LIST: break;
+        }
+
+        jassertfalse;
+        return "";
+    }
+
+    struct Options
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        double secondsPerScenario = 2.0;
+        double deadlineMs = 0.0; // 0: 20 times the block length
+        juce::StringArray suppressions;
+        bool useDefaultSuppressions = true;
+        bool openEditor = true;
+        bool abortOnViolation = false;
+    };
+
+    void printUsage()
+    {
+        std::cout << "usage: RealtimeAudit [--seconds <per scenario>] [--block <samples>] [--rate <hz>] [--deadline <ms>]\n"
+                     "                     [--suppressions <file>] [--no-default-suppressions] [--no-editor] [--abort]\n";
+    }
+
+    bool loadSuppressions(const juce::File& file, juce::StringArray& suppressions)
+    {
+        if (! file.existsAsFile())
+            return false;
+
+        for (auto line : juce::StringArray::fromLines(file.loadFileAsString()))
+        {
+            line = line.upToFirstOccurrenceOf("#", false, false).trim();
+            if (line.isNotEmpty())
+                suppressions.add(line);
+        }
+
+        return true;
+    }
+
+    bool parseOptions(const juce::ArgumentList& args, Options& options)
+    {
+        for (int i = 0; i < args.size(); ++i)
+        {
+            const auto& arg = args[i];
+            auto nextValue = [&]() { return i + 1 < args.size() ? args[++i].text : juce::String(); };
+
+            if (arg == "--seconds")
+            {
+                options.secondsPerScenario = juce::jlimit(0.1, 3600.0, nextValue().getDoubleValue());
+            }
+            else if (arg == "--block")
+            {
+                options.blockSize = juce::jlimit(1, 65536, nextValue().getIntValue());
+            }
+            else if (arg == "--rate")
+            {
+                options.sampleRate = juce::jlimit(8000.0, 768000.0, nextValue().getDoubleValue());
+            }
+            else if (arg == "--deadline")
+            {
+                options.deadlineMs = juce::jmax(0.0, nextValue().getDoubleValue());
+            }
+            else if (arg == "--suppressions")
+            {
+                auto file = juce::File::getCurrentWorkingDirectory().getChildFile(nextValue());
+                if (! loadSuppressions(file, options.suppressions))
+                {
+                    std::cerr << "couldn't read suppressions from " << file.getFullPathName() << "\n";
+                    return false;
+                }
+            }
+            else if (arg == "--no-default-suppressions")
+            {
+                options.useDefaultSuppressions = false;
+            }
+            else if (arg == "--no-editor")
+            {
+                options.openEditor = false;
+            }
+            else if (arg == "--abort")
+            {
+                options.abortOnViolation = true;
+            }
+            else
+            {
+                std::cerr << "unknown option " << arg.text << "\n";
+                return false;
+            }
+        }
+
+        if (options.useDefaultSuppressions)
+            for (auto* suppression : defaultSuppressions)
+                options.suppressions.add(suppression);
+
+        if (options.deadlineMs <= 0.0)
+            options.deadlineMs = 20.0 * 1000.0 * options.blockSize / options.sampleRate;
+
+        return true;
+    }
+
+    /*
+        the simulated host audio thread. everything it needs is allocated up front,
+        so anything reported from it comes from the processor.
+    */
+    struct AudioThread : juce::Thread
+    {
+        AudioThread(CAudioPluginAudioProcessor& processorToRun, const Options& optionsToUse)
+            : juce::Thread("RealtimeAudit audio"),
+              processor(processorToRun),
+              options(optionsToUse)
+        {
+            for (auto* parameter : processor.getParameters())
+                parameters.push_back(parameter);
+
+            buffer.setSize(numChannels, options.blockSize);
+            noise.setSize(numChannels, options.blockSize);
+
+            juce::Random random(0x5eed);
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int i = 0; i < options.blockSize; ++i)
+                    noise.setSample(ch, i, random.nextFloat() * 0.5f - 0.25f);
+        }
+
+        void run() override
+        {
+            juce::Random random(0xa0d17);
+
+            while (! threadShouldExit())
+            {
+                //most hosts call with full blocks, some split them at automation points or loop boundaries.
+                const auto numSamples = random.nextInt(4) == 0 ? 1 + random.nextInt(options.blockSize) : options.blockSize;
+
+                {
+                    AllocationTracker::ScopedRealtimeSection realtimeSection;
+                    callStartMs.store(juce::Time::getMillisecondCounterHiRes());
+
+                    if (automating.load())
+                        automateParameters(random);
+
+                    buffer.setSize(numChannels, numSamples, false, false, true);
+                    for (int ch = 0; ch < numChannels; ++ch)
+                        buffer.copyFrom(ch, 0, noise, ch, 0, numSamples);
+
+                    processor.processBlock(buffer, midi);
+
+                    callStartMs.store(0.0);
+                    ++numCallbacks;
+                }
+
+                //roughly realtime, so the message thread gets to race the callbacks
+                const auto blockMs = 1000.0 * numSamples / options.sampleRate;
+                juce::Thread::sleep(juce::jmax(0, juce::roundToInt(blockMs * 0.5)));
+            }
+        }
+
+        // set the value, then tell the listeners, like JUCE's wrappers do. a few parameters per callback, in turn.
+        void automateParameters(juce::Random& random)
+        {
+            for (int i = 0; i < numParametersPerCallback; ++i)
+            {
+                auto* parameter = parameters[nextParameter];
+                nextParameter = (nextParameter + 1) % parameters.size();
+
+                const auto value = random.nextFloat();
+                parameter->setValue(value);
+                parameter->sendValueChangedMessageToListeners(value);
+            }
+        }
+
+        CAudioPluginAudioProcessor& processor;
+        const Options& options;
+
+        std::vector<juce::AudioProcessorParameter*> parameters;
+        size_t nextParameter = 0;
+
+        juce::AudioBuffer<float> buffer, noise;
+        juce::MidiBuffer midi;
+
+        std::atomic<bool> automating{ false };
+        std::atomic<double> callStartMs{ 0.0 }; // 0 between callbacks
+        std::atomic<int> numCallbacks{ 0 };
+    };
+
+    //reports a callback that runs past the deadline, once per callback.
+    struct Watchdog : juce::Thread
+    {
+        Watchdog(const AudioThread& audioThread, double deadline)
+            : juce::Thread("RealtimeAudit watchdog"),
+              audio(audioThread),
+              deadlineMs(deadline)
+        {
+        }
+
+        void run() override
+        {
+            double lastReportedStartMs = 0.0;
+
+            while (! threadShouldExit())
+            {
+                const auto startMs = audio.callStartMs.load();
+                if (startMs > 0.0 && startMs != lastReportedStartMs
+                    && juce::Time::getMillisecondCounterHiRes() - startMs > deadlineMs)
+                {
+                    RealtimeInterceptors::reportViolation("callback ran past the deadline", false);
+                    lastReportedStartMs = startMs;
+                }
+
+                wait(1);
+            }
+        }
+
+        const AudioThread& audio;
+        double deadlineMs;
+    };
+
+    //the message thread side. one scenario after the other, then it stops the dispatch loop.
+    struct ScenarioRunner : private juce::Timer
+    {
+        ScenarioRunner(CAudioPluginAudioProcessor& processorToUse, AudioThread& audioThread, const Options& optionsToUse)
+            : processor(processorToUse),
+              audio(audioThread),
+              options(optionsToUse)
+        {
+            //the state scenario swaps between the defaults and a state with every parameter somewhere else.
+            processor.getStateInformation(states[0]);
+
+            for (auto* parameter : processor.getParameters())
+                parameter->setValueNotifyingHost(random.nextFloat());
+
+            processor.getStateInformation(states[1]);
+            processor.setStateInformation(states[0].getData(), static_cast<int>(states[0].getSize()));
+        }
+
+        ~ScenarioRunner() override
+        {
+            stopTimer();
+        }
+
+        void start()
+        {
+            startScenario(Scenario::Steady);
+            startTimer(tickMs);
+        }
+
+        void stopEditor()
+        {
+            editor.reset();
+        }
+
+    private:
+        void startScenario(Scenario newScenario)
+        {
+            scenario = newScenario;
+            numTicks = 0;
+            scenarioEndMs = juce::Time::getMillisecondCounterHiRes() + options.secondsPerScenario * 1000.0;
+
+            RealtimeInterceptors::setScenario(getScenarioName(scenario));
+            audio.automating.store(scenario == Scenario::Automation);
+
+            std::cout << "scenario " << getScenarioName(scenario) << "\n";
+        }
+
+        void timerCallback() override
+        {
+            if (juce::Time::getMillisecondCounterHiRes() < scenarioEndMs)
+            {
+                tick();
+                ++numTicks;
+                return;
+            }
+
+            stopEditor();
+
+            auto next = static_cast<Scenario>(static_cast<int>(scenario) + 1);
+            if (next == Scenario::Editor && ! options.openEditor)
+                next = Scenario::END_OF_LIST;
+
+            if (next != Scenario::END_OF_LIST)
+            {
+                startScenario(next);
+                return;
+            }
+
+            stopTimer();
+            juce::MessageManager::getInstance()->stopDispatchLoop();
+        }
+
+        void tick()
+        {
+            switch (scenario)
+            {
+                case Scenario::Reorder:
+                {
+                    processor.dspOrderFifo.push(getDSPOrderFromIndex(static_cast<size_t>(random.nextInt(static_cast<int>(NumDSPOrders)))));
+                    break;
+                }
+                case Scenario::State:
+                {
+                    const auto& state = states[static_cast<size_t>(numTicks % 2)];
+                    processor.setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+                    break;
+                }
+                case Scenario::Editor:
+                {
+                    if (numTicks % editorToggleTicks != 0)
+                        break;
+
+                    if (editor != nullptr)
+                        editor.reset();
+                    else
+                        editor.reset(processor.createEditorIfNeeded());
+                    break;
+                }
+                case Scenario::Steady:
+                case Scenario::Automation:
+                case Scenario::END_OF_LIST:
+                    break;
+            }
+        }
+
+        CAudioPluginAudioProcessor& processor;
+        AudioThread& audio;
+        const Options& options;
+
+        juce::Random random{ 0x57a7e };
+        std::array<juce::MemoryBlock, 2> states;
+        std::unique_ptr<juce::AudioProcessorEditor> editor;
+
+        Scenario scenario = Scenario::Steady;
+        int numTicks = 0;
+        double scenarioEndMs = 0.0;
+    };
+
+    //frames from the plugin's own sources. the allocation tracker and this tool don't count.
+    bool isPluginFrame(const juce::String& frame)
+    {
+        return frame.contains("/Source/")
+            && ! frame.contains("/Source/Diagnostics/")
+            && ! frame.contains("RealtimeAudit/");
+    }
+
+    //the first line is the intercepted function itself, the walk starts at its caller.
+    bool isSuppressed(const juce::StringArray& stack, const juce::StringArray& suppressions)
+    {
+        for (int i = 1; i < stack.size(); ++i)
+        {
+            if (isPluginFrame(stack[i]))
+                return false;
+
+            for (const auto& suppression : suppressions)
+                if (stack[i].contains(suppression))
+                    return true;
+        }
+
+        return false;
+    }
+
+    // prints every unsuppressed violation once per call stack, returns how many distinct ones there were.
+    int printReport(const Options& options)
+    {
+        struct Entry
+        {
+            const RealtimeInterceptors::Violation* violation = nullptr;
+            int count = 0;
+        };
+
+        //the raw frames are the key, so every stack is only symbolized once
+        std::map<juce::String, Entry> entries;
+
+        const auto numViolations = RealtimeInterceptors::getNumViolations();
+        const auto numLogged = juce::jmin(numViolations, RealtimeInterceptors::maxNumViolations);
+
+        for (int i = 0; i < numLogged; ++i)
+        {
+            const auto& violation = RealtimeInterceptors::getViolation(i);
+
+            juce::String key = juce::String(violation.function) + "/" + violation.scenario;
+            for (int frame = 0; frame < violation.numFrames; ++frame)
+                key << "/" << juce::String::toHexString(reinterpret_cast<juce::pointer_sized_int>(violation.frames[frame]));
+
+            auto& entry = entries[key];
+            entry.violation = &violation;
+            ++entry.count;
+        }
+
+        int numReported = 0, numSuppressed = 0;
+        for (const auto& [key, entry] : entries)
+        {
+            const auto stack = RealtimeInterceptors::symbolize(*entry.violation);
+            if (isSuppressed(stack, options.suppressions))
+            {
+                numSuppressed += entry.count;
+                continue;
+            }
+
+            ++numReported;
+            std::cout << "\n" << entry.violation->function << " on the audio thread, "
+                      << entry.count << "x in scenario " << entry.violation->scenario << "\n";
+
+            for (const auto& frame : stack)
+                std::cout << "    " << frame << "\n";
+        }
+
+        std::cout << "\n" << numReported << " distinct realtime violations, " << numSuppressed << " suppressed\n";
+        if (numViolations > numLogged)
+            std::cout << "the log was full, " << numViolations - numLogged << " violations weren't checked\n";
+
+        return numReported;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    //first, so nothing is resolved lazily on the audio thread.
+    if (! RealtimeInterceptors::install())
+    {
+        std::cerr << "RealtimeAudit needs Linux\n";
+        return 1;
+    }
+
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    Options options;
+    if (! parseOptions(juce::ArgumentList(argc, argv), options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    RealtimeInterceptors::setAbortOnViolation(options.abortOnViolation);
+
+    CAudioPluginAudioProcessor processor;
+    processor.setPlayConfigDetails(numChannels, numChannels, options.sampleRate, options.blockSize);
+    processor.prepareToPlay(options.sampleRate, options.blockSize);
+
+    AudioThread audio(processor, options);
+    Watchdog watchdog(audio, options.deadlineMs);
+    ScenarioRunner runner(processor, audio, options);
+
+    if (! audio.startRealtimeThread(juce::Thread::RealtimeOptions{}))
+        audio.startThread(juce::Thread::Priority::highest);
+
+    watchdog.startThread();
+    runner.start();
+
+    juce::MessageManager::getInstance()->runDispatchLoop();
+
+    audio.stopThread(1000);
+    watchdog.stopThread(1000);
+    runner.stopEditor();
+    processor.releaseResources();
+
+    std::cout << audio.numCallbacks.load() << " callbacks of up to " << options.blockSize << " samples at "
+              << options.sampleRate << " Hz, deadline " << options.deadlineMs << " ms\n";
+
+    return printReport(options) == 0 ? 0 : 1;
+}
@@ -0,0 +1,387 @@
+/*
+  ==============================================================================
+
+    RealtimeInterceptors.cpp
+
+  ==============================================================================
+*/
+
+//the fortified inline versions of read() and co. would clash with the replacements below
+#undef _FORTIFY_SOURCE
+
+#include "RealtimeInterceptors.h"
+#include "../../Source/Diagnostics/AllocationTracker.h"
+
+#if JUCE_LINUX
+ #include <cxxabi.h>
+ #include <dlfcn.h>
+ #include <elf.h>
+ #include <execinfo.h>
+ #include <fcntl.h>
+ #include <link.h>
+ #include <malloc.h>
+ #include <poll.h>
+ #include <pthread.h>
+ #include <sched.h>
+ #include <semaphore.h>
+ #include <sys/mman.h>
+ #include <sys/select.h>
+ #include <sys/socket.h>
+ #include <unistd.h>
+ #include <cerrno>
+ #include <cstdarg>
+ #include <cstdio>
+ #include <cstring>
+#endif
+
+namespace
+{
+    std::array<RealtimeInterceptors::Violation, RealtimeInterceptors::maxNumViolations> violations;
+    std::atomic<int> numViolations{ 0 };
+
+    std::atomic<const char*> currentScenario{ "" };
+    std::atomic<bool> abortOnViolation{ false };
+
+    //set while a violation is recorded, so backtrace() and the abort message don't report themselves.
+    thread_local bool isRecording = false;
+
+   #if JUCE_LINUX
+    void checkRealtime(const char* function) noexcept
+    {
+        if (AllocationTracker::isInRealtimeSection())
+            RealtimeInterceptors::reportViolation(function, true);
+    }
+
+    void* resolve(std::atomic<void*>& real, const char* name) noexcept
+    {
+        auto* function = real.load(std::memory_order_relaxed);
+        if (function == nullptr)
+        {
+            function = dlsym(RTLD_NEXT, name);
+            jassert(function != nullptr);
+            real.store(function, std::memory_order_relaxed);
+        }
+
+        return function;
+    }
+
+    bool needsMode(int flags) noexcept
+    {
+        return (flags & O_CREAT) != 0 || (flags & O_TMPFILE) == O_TMPFILE;
+    }
+   #endif
+}
+
+void RealtimeInterceptors::setAbortOnViolation(bool shouldAbort) noexcept
+{
+    abortOnViolation.store(shouldAbort);
+}
+
+void RealtimeInterceptors::setScenario(const char* name) noexcept
+{
+    currentScenario.store(name);
+}
+
+void RealtimeInterceptors::reportViolation(const char* function, bool captureStack) noexcept
+{
+    if (isRecording)
+        return;
+
+    isRecording = true;
+
+    const auto index = numViolations.fetch_add(1);
+    if (index < maxNumViolations)
+    {
+        auto& violation = violations[static_cast<size_t>(index)];
+        violation.function = function;
+        violation.scenario = currentScenario.load();
+
+       #if JUCE_LINUX
+        if (captureStack)
+            violation.numFrames = backtrace(violation.frames, maxNumFrames);
+       #else
+        juce::ignoreUnused(captureStack);
+       #endif
+    }
+
+    if (abortOnViolation.load())
+    {
+        std::fputs("realtime violation: ", stderr);
+        std::fputs(function, stderr);
+        std::fputs("\n", stderr);
+        std::abort();
+    }
+
+    isRecording = false;
+}
+
+int RealtimeInterceptors::getNumViolations() noexcept
+{
+    return numViolations.load();
+}
+
+const RealtimeInterceptors::Violation& RealtimeInterceptors::getViolation(int index) noexcept
+{
+    jassert(index >= 0 && index < juce::jmin(getNumViolations(), maxNumViolations));
+    return violations[static_cast<size_t>(index)];
+}
+
+#if JUCE_LINUX
+namespace
+{
+    juce::String demangle(const char* name)
+    {
+        int status = 0;
+        if (auto* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status))
+        {
+            juce::String result(demangled);
+            std::free(demangled);
+            return result;
+        }
+
+        return name;
+    }
+
+    // "function  file:line" for the code at offset in file, one line per inlined frame.
+    juce::StringArray runAddr2Line(const juce::String& file, juce::pointer_sized_uint offset)
+    {
+        static std::map<juce::String, juce::StringArray> cache;
+
+        const auto key = file + ":" + juce::String::toHexString(static_cast<juce::int64>(offset));
+        if (auto found = cache.find(key); found != cache.end())
+            return found->second;
+
+        juce::StringArray frames;
+        juce::ChildProcess addr2line;
+        if (addr2line.start(juce::StringArray{ "addr2line", "-C", "-f", "-i", "-e", file, "0x" + juce::String::toHexString(static_cast<juce::int64>(offset)) }))
+        {
+            auto lines = juce::StringArray::fromLines(addr2line.readAllProcessOutput().trim());
+            for (int i = 0; i + 1 < lines.size(); i += 2)
+            {
+                if (lines[i] != "??")
+                    frames.add(lines[i] + "  " + lines[i + 1]);
+            }
+        }
+
+        cache[key] = frames;
+        return frames;
+    }
+}
+#endif
+
+juce::StringArray RealtimeInterceptors::symbolize(const Violation& violation)
+{
+    juce::StringArray lines;
+
+   #if JUCE_LINUX
+    for (int i = 0; i < violation.numFrames; ++i)
+    {
+        Dl_info info{};
+        if (dladdr(violation.frames[i], &info) == 0 || info.dli_fname == nullptr)
+        {
+            lines.add("0x" + juce::String::toHexString(reinterpret_cast<juce::pointer_sized_int>(violation.frames[i])));
+            continue;
+        }
+
+        //every frame is a return address, step back into the call. position independent objects are looked up by offset.
+        auto address = reinterpret_cast<juce::pointer_sized_uint>(violation.frames[i]) - 1;
+        if (static_cast<const ElfW(Ehdr)*>(info.dli_fbase)->e_type == ET_DYN)
+            address -= reinterpret_cast<juce::pointer_sized_uint>(info.dli_fbase);
+
+        auto frames = runAddr2Line(info.dli_fname, address);
+        if (frames.isEmpty())
+        {
+            //no symbol table or no addr2line, the dynamic symbols are all there is.
+            frames.add((info.dli_sname != nullptr ? demangle(info.dli_sname) : juce::String("??"))
+                       + "  " + info.dli_fname + "+0x" + juce::String::toHexString(static_cast<juce::int64>(address)));
+        }
+
+        lines.addArray(frames);
+    }
+
+    //the stack starts inside the reporting code, drop it so the first line is the intercepted function.
+    while (! lines.isEmpty() && (lines[0].contains("reportViolation") || lines[0].contains("checkRealtime")))
+        lines.remove(0);
+   #else
+    juce::ignoreUnused(violation);
+   #endif
+
+    return lines;
+}
+
+#if JUCE_LINUX
+//==============================================================================
+/*
+    the replacements. they have to be visible to the shared libraries, so their calls land here too.
+    the allocation functions forward to glibc's own entry points, dlsym() itself allocates.
+*/
+#define REALTIME_INTERCEPTOR extern "C" __attribute__((visibility("default")))
+
+extern "C"
+{
+    void* __libc_malloc(size_t) noexcept;
+    void* __libc_calloc(size_t, size_t) noexcept;
+    void* __libc_realloc(void*, size_t) noexcept;
+    void* __libc_memalign(size_t, size_t) noexcept;
+    void __libc_free(void*) noexcept;
+}
+
+REALTIME_INTERCEPTOR void* malloc(size_t size) noexcept
+{
+    checkRealtime("malloc");
+    return __libc_malloc(size);
+}
+
+REALTIME_INTERCEPTOR void* calloc(size_t count, size_t size) noexcept
+{
+    checkRealtime("calloc");
+    return __libc_calloc(count, size);
+}
+
+REALTIME_INTERCEPTOR void* realloc(void* ptr, size_t size) noexcept
+{
+    checkRealtime("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+REALTIME_INTERCEPTOR void free(void* ptr) noexcept
+{
+    if (ptr != nullptr)
+        checkRealtime("free");
+
+    __libc_free(ptr);
+}
+
+REALTIME_INTERCEPTOR void* memalign(size_t alignment, size_t size) noexcept
+{
+    checkRealtime("memalign");
+    return __libc_memalign(alignment, size);
+}
+
+REALTIME_INTERCEPTOR void* aligned_alloc(size_t alignment, size_t size) noexcept
+{
+    checkRealtime("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+REALTIME_INTERCEPTOR int posix_memalign(void** result, size_t alignment, size_t size) noexcept
+{
+    checkRealtime("posix_memalign");
+
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+
+    auto* ptr = __libc_memalign(alignment, size);
+    if (ptr == nullptr)
+        return ENOMEM;
+
+    *result = ptr;
+    return 0;
+}
+
+//==============================================================================
+// everything that can lock, wait, sleep or go to the file system. name, return type, parameters, arguments, exception spec.
+#define REALTIME_INTERCEPTED_FUNCTIONS(X) \
+    X(pthread_mutex_lock,     int,     (pthread_mutex_t* m),                                                   (m),                noexcept) \
+    X(pthread_rwlock_rdlock,  int,     (pthread_rwlock_t* l),                                                  (l),                noexcept) \
+    X(pthread_rwlock_wrlock,  int,     (pthread_rwlock_t* l),                                                  (l),                noexcept) \
+    X(pthread_cond_wait,      int,     (pthread_cond_t* c, pthread_mutex_t* m),                                (c, m),                     ) \
+    X(pthread_cond_timedwait, int,     (pthread_cond_t* c, pthread_mutex_t* m, const timespec* t),             (c, m, t),                  ) \
+    X(pthread_cond_signal,    int,     (pthread_cond_t* c),                                                    (c),                noexcept) \
+    X(pthread_cond_broadcast, int,     (pthread_cond_t* c),                                                    (c),                noexcept) \
+    X(pthread_join,           int,     (pthread_t t, void** r),                                                (t, r),                     ) \
+    X(sem_wait,               int,     (sem_t* s),                                                             (s),                        ) \
+    X(sem_timedwait,          int,     (sem_t* s, const timespec* t),                                          (s, t),                     ) \
+    X(close,                  int,     (int fd),                                                               (fd),                       ) \
+    X(read,                   ssize_t, (int fd, void* b, size_t n),                                            (fd, b, n),                 ) \
+    X(write,                  ssize_t, (int fd, const void* b, size_t n),                                      (fd, b, n),                 ) \
+    X(pread,                  ssize_t, (int fd, void* b, size_t n, off_t o),                                   (fd, b, n, o),              ) \
+    X(pwrite,                 ssize_t, (int fd, const void* b, size_t n, off_t o),                             (fd, b, n, o),              ) \
+    X(fopen,                  FILE*,   (const char* p, const char* m),                                         (p, m),                     ) \
+    X(fclose,                 int,     (FILE* f),                                                              (f),                        ) \
+    X(fread,                  size_t,  (void* b, size_t s, size_t n, FILE* f),                                 (b, s, n, f),               ) \
+    X(fwrite,                 size_t,  (const void* b, size_t s, size_t n, FILE* f),                           (b, s, n, f),               ) \
+    X(fflush,                 int,     (FILE* f),                                                              (f),                        ) \
+    X(fputs,                  int,     (const char* s, FILE* f),                                               (s, f),                     ) \
+    X(puts,                   int,     (const char* s),                                                        (s),                        ) \
+    X(mmap,                   void*,   (void* a, size_t n, int p, int f, int fd, off_t o),                     (a, n, p, f, fd, o), noexcept) \
+    X(munmap,                 int,     (void* a, size_t n),                                                    (a, n),             noexcept) \
+    X(mprotect,               int,     (void* a, size_t n, int p),                                             (a, n, p),          noexcept) \
+    X(nanosleep,              int,     (const timespec* r, timespec* rem),                                     (r, rem),                   ) \
+    X(clock_nanosleep,        int,     (clockid_t c, int f, const timespec* r, timespec* rem),                 (c, f, r, rem),             ) \
+    X(usleep,                 int,     (useconds_t u),                                                         (u),                        ) \
+    X(sleep,                  unsigned int, (unsigned int s),                                                  (s),                        ) \
+    X(sched_yield,            int,     (),                                                                     (),                 noexcept) \
+    X(poll,                   int,     (pollfd* f, nfds_t n, int t),                                           (f, n, t),                  ) \
+    X(select,                 int,     (int n, fd_set* r, fd_set* w, fd_set* e, timeval* t),                   (n, r, w, e, t),            ) \
+    X(send,                   ssize_t, (int fd, const void* b, size_t n, int f),                               (fd, b, n, f),              ) \
+    X(recv,                   ssize_t, (int fd, void* b, size_t n, int f),                                     (fd, b, n, f),              )
+
+#define REALTIME_DEFINE_INTERCEPTOR(name, returnType, params, args, spec)                                   \
+    static std::atomic<void*> real_##name{ nullptr };                                                       \
+    REALTIME_INTERCEPTOR returnType name params spec                                                        \
+    {                                                                                                       \
+        checkRealtime(#name);                                                                               \
+        return reinterpret_cast<returnType (*) params spec>(resolve(real_##name, #name)) args;              \
+    }
+
+REALTIME_INTERCEPTED_FUNCTIONS(REALTIME_DEFINE_INTERCEPTOR)
+
+// open() and openat() only pass a mode when they create a file.
+static std::atomic<void*> real_open{ nullptr };
+static std::atomic<void*> real_openat{ nullptr };
+
+REALTIME_INTERCEPTOR int open(const char* path, int flags, ...)
+{
+    checkRealtime("open");
+
+    mode_t mode = 0;
+    if (needsMode(flags))
+    {
+        va_list args;
+        va_start(args, flags);
+        mode = va_arg(args, mode_t);
+        va_end(args);
+    }
+
+    return reinterpret_cast<int (*)(const char*, int, ...)>(resolve(real_open, "open"))(path, flags, mode);
+}
+
+REALTIME_INTERCEPTOR int openat(int directory, const char* path, int flags, ...)
+{
+    checkRealtime("openat");
+
+    mode_t mode = 0;
+    if (needsMode(flags))
+    {
+        va_list args;
+        va_start(args, flags);
+        mode = va_arg(args, mode_t);
+        va_end(args);
+    }
+
+    return reinterpret_cast<int (*)(int, const char*, int, ...)>(resolve(real_openat, "openat"))(directory, path, flags, mode);
+}
+
+bool RealtimeInterceptors::install()
+{
+    #define REALTIME_RESOLVE_INTERCEPTOR(name, returnType, params, args, spec) resolve(real_##name, #name);
+    REALTIME_INTERCEPTED_FUNCTIONS(REALTIME_RESOLVE_INTERCEPTOR)
+    #undef REALTIME_RESOLVE_INTERCEPTOR
+
+    resolve(real_open, "open");
+    resolve(real_openat, "openat");
+
+    //the first backtrace() loads libgcc, which allocates
+    void* frame = nullptr;
+    backtrace(&frame, 1);
+
+    return true;
+}
+
+#else
+bool RealtimeInterceptors::install()
+{
+    return false;
+}
+#endif
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    RealtimeInterceptors.h
+
+    Linux only. Replaces malloc & co., the pthread locking and waiting
+    functions, and the blocking and file system calls for the whole process,
+    in the spirit of RealtimeSanitizer.
+    Every replacement forwards to the real function, but first records a
+    violation if the calling thread is inside an
+    AllocationTracker::ScopedRealtimeSection (see isInRealtimeSection()).
+    Recording doesn't allocate or lock: the function name and the raw call
+    stack go into a fixed size log, which is symbolized once the audit is
+    over.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace RealtimeInterceptors
+{
+    static constexpr int maxNumFrames = 32;
+    static constexpr int maxNumViolations = 4096;
+
+    struct Violation
+    {
+        const char* function = nullptr;
+        const char* scenario = nullptr;
+
+        // innermost first, starting at the intercepted function. empty for the watchdog's deadline misses.
+        void* frames[maxNumFrames]{};
+        int numFrames = 0;
+    };
+
+    /*
+        resolves every real function up front, so nothing is looked up on the audio thread.
+        false if the interceptors aren't available on this platform.
+        call it first thing in main().
+    */
+    bool install();
+
+    // abort() at the first violation, so a debugger stops right on it.
+    void setAbortOnViolation(bool shouldAbort) noexcept;
+
+    // stored with every violation from now on. must outlive the audit, i.e. be a string literal.
+    void setScenario(const char* name) noexcept;
+
+    // records a violation for the calling thread, whether it is in a realtime section or not.
+    void reportViolation(const char* function, bool captureStack) noexcept;
+
+    // every violation so far, including the ones that didn't fit in the log.
+    int getNumViolations() noexcept;
+
+    // only call this once the audio thread has stopped. index < min(getNumViolations(), maxNumViolations)
+    const Violation& getViolation(int index) noexcept;
+
+    /*
+        one "function  file:line" line per frame, inlined frames included, innermost first.
+        runs addr2line, so it needs debug info for file names and can't be called on the audio thread.
+    */
+    juce::StringArray symbolize(const Violation& violation);
+}
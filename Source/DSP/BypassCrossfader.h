@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    BypassCrossfader.h
+
+    Per-stage bypass state for the chain.
+    A bypassed stage isn't processed at all. When a stage is toggled, it is
+    processed for fadeLengthSeconds more while its output (wet) is
+    equal-power crossfaded against its input (dry):
+        wet = sin(theta), dry = cos(theta), theta from 0 to pi/2
+    A stage coming back from a full bypass is asked to reset first, so it
+    doesn't start with whatever state it had when it was switched off.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "VectorKernels.h"
+
+template<typename SampleType, size_t NumStages>
+struct BypassCrossfader
+{
+    static constexpr double fadeLengthSeconds = 0.01;
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        fadeLengthInSamples = juce::jmax(1, static_cast<int>(std::round(spec.sampleRate * fadeLengthSeconds)));
+
+        dry.setSize(static_cast<int>(spec.numChannels), static_cast<int>(spec.maximumBlockSize));
+        wetGains.resize(spec.maximumBlockSize);
+        dryGains.resize(spec.maximumBlockSize);
+
+        reset();
+    }
+
+    // ends every fade.
+    void reset()
+    {
+        for (auto& stage : stages)
+            stage.position = stage.bypassed ? 0 : fadeLengthInSamples;
+    }
+
+    /*
+        starts a fade if the bypass state changed.
+        returns true if the stage was fully bypassed and needs a reset() before it is processed again.
+    */
+    bool setBypassed(size_t index, bool shouldBeBypassed) noexcept
+    {
+        auto& stage = stages[index];
+        if (stage.bypassed == shouldBeBypassed)
+            return false;
+
+        stage.bypassed = shouldBeBypassed;
+        return ! shouldBeBypassed && stage.position == 0;
+    }
+
+    // takes over the bypass state and fade position of one stage of another chain's crossfader.
+    void copyStageFrom(const BypassCrossfader& other, size_t index) noexcept
+    {
+        jassert(fadeLengthInSamples == other.fadeLengthInSamples);
+        stages[index] = other.stages[index];
+    }
+
+    bool isFullyBypassed(size_t index) const noexcept
+    {
+        return stages[index].bypassed && stages[index].position == 0;
+    }
+
+    bool isFading(size_t index) const noexcept
+    {
+        const auto& stage = stages[index];
+        return stage.position != (stage.bypassed ? 0 : fadeLengthInSamples);
+    }
+
+    // keep a copy of the stage input. only needed while the stage isFading().
+    void storeDry(const juce::dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        const auto numSamples = static_cast<int>(block.getNumSamples());
+        const auto numChannels = juce::jmin(block.getNumChannels(), static_cast<size_t>(dry.getNumChannels()));
+        jassert(numSamples <= dry.getNumSamples());
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+            juce::FloatVectorOperations::copy(dry.getWritePointer(static_cast<int>(ch)), block.getChannelPointer(ch), numSamples);
+    }
+
+    // the input storeDry() kept, for a stage whose dry path needs processing of its own (see CompensationDelay).
+    juce::dsp::AudioBlock<SampleType> getDry(size_t numChannels, size_t numSamples) noexcept
+    {
+        return juce::dsp::AudioBlock<SampleType>(dry).getSubsetChannelBlock(0, juce::jmin(numChannels, static_cast<size_t>(dry.getNumChannels())))
+                                                     .getSubBlock(0, numSamples);
+    }
+
+    // crossfades the stage output in block against the stored input, and moves the fade along.
+    void mixWithDry(size_t index, const juce::dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        auto& stage = stages[index];
+        const auto numSamples = block.getNumSamples();
+        const auto direction = stage.bypassed ? -1 : 1;
+        const auto halfPi = juce::MathConstants<SampleType>::halfPi;
+
+        //the gains are worked out once and shared by every channel
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            stage.position = juce::jlimit(0, fadeLengthInSamples, stage.position + direction);
+            const auto theta = halfPi * static_cast<SampleType>(stage.position) / static_cast<SampleType>(fadeLengthInSamples);
+
+            wetGains[i] = std::sin(theta);
+            dryGains[i] = std::cos(theta);
+        }
+
+        const auto numChannels = juce::jmin(block.getNumChannels(), static_cast<size_t>(dry.getNumChannels()));
+        for (size_t ch = 0; ch < numChannels; ++ch)
+            kernels.mix(block.getChannelPointer(ch), dry.getReadPointer(static_cast<int>(ch)), wetGains.data(), dryGains.data(), numSamples);
+    }
+
+private:
+    struct Stage
+    {
+        bool bypassed = false;
+
+        //0 is fully bypassed, fadeLengthInSamples is fully active
+        int position = 0;
+    };
+
+    std::array<Stage, NumStages> stages{};
+    int fadeLengthInSamples = 1;
+
+    juce::AudioBuffer<SampleType> dry;
+    std::vector<SampleType> wetGains, dryGains;
+
+    const VectorKernels<SampleType>& kernels = VectorKernels<SampleType>::get();
+};
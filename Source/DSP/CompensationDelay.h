@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    CompensationDelay.h
+
+    A whole-sample delay that keeps the signal around a stage with latency
+    in time with the stage's output. The chain reports the overdrive's
+    latency whether the overdrive runs or not, so while it is bypassed its
+    input is delayed by the same amount, and while it fades in or out its
+    dry signal is.
+    It is fed the input even while the stage runs, so it holds the right
+    samples the moment a fade starts.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+template<typename SampleType>
+struct CompensationDelay
+{
+    void prepare(const juce::dsp::ProcessSpec& spec, int maxDelaySamples)
+    {
+        //a power of two, so wrapping the positions is a mask
+        const auto lineLength = juce::nextPowerOfTwo(juce::jmax(1, maxDelaySamples) + 1);
+        lines.setSize(static_cast<int>(spec.numChannels), lineLength);
+        mask = lineLength - 1;
+
+        delaySamples = juce::jmin(delaySamples, mask);
+        reset();
+    }
+
+    void reset()
+    {
+        lines.clear();
+        writeIndex = 0;
+    }
+
+    // a new delay starts from silence, it only changes along with the stage's latency.
+    void setDelay(int newDelaySamples) noexcept
+    {
+        jassert(newDelaySamples >= 0 && newDelaySamples <= mask);
+        newDelaySamples = juce::jlimit(0, mask, newDelaySamples);
+
+        if (newDelaySamples == delaySamples)
+            return;
+
+        delaySamples = newDelaySamples;
+        reset();
+    }
+
+    int getDelay() const noexcept { return delaySamples; }
+
+    // both have to be prepared with the same spec. the lines are only as long as the delay, so all of them is copied.
+    void copyStateFrom(const CompensationDelay& other) noexcept
+    {
+        jassert(lines.getNumChannels() == other.lines.getNumChannels() && lines.getNumSamples() == other.lines.getNumSamples());
+
+        for (int ch = 0; ch < lines.getNumChannels(); ++ch)
+            lines.copyFrom(ch, 0, other.lines, ch, 0, lines.getNumSamples());
+
+        writeIndex = other.writeIndex;
+        delaySamples = other.delaySamples;
+    }
+
+    // delays block in place.
+    void process(const juce::dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        const auto numSamples = block.getNumSamples();
+        const auto numChannels = juce::jmin(block.getNumChannels(), static_cast<size_t>(lines.getNumChannels()));
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            auto* line = lines.getWritePointer(static_cast<int>(ch));
+            auto* samples = block.getChannelPointer(ch);
+            auto index = writeIndex;
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                line[index] = samples[i];
+                samples[i] = line[(index - delaySamples) & mask];
+                index = (index + 1) & mask;
+            }
+        }
+
+        advance(numSamples);
+    }
+
+    // only takes in block, for while the stage runs and its own output is used.
+    void push(const juce::dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        const auto numSamples = block.getNumSamples();
+        const auto numChannels = juce::jmin(block.getNumChannels(), static_cast<size_t>(lines.getNumChannels()));
+        const auto lineLength = mask + 1;
+
+        //anything older than the line is long can't be read any more
+        const auto numToWrite = static_cast<int>(juce::jmin(numSamples, static_cast<size_t>(lineLength)));
+        const auto skipped = numSamples - static_cast<size_t>(numToWrite);
+        const auto start = static_cast<int>((static_cast<size_t>(writeIndex) + skipped) & static_cast<size_t>(mask));
+        const auto firstPart = juce::jmin(numToWrite, lineLength - start);
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            auto* line = lines.getWritePointer(static_cast<int>(ch));
+            const auto* samples = block.getChannelPointer(ch) + skipped;
+
+            juce::FloatVectorOperations::copy(line + start, samples, firstPart);
+            juce::FloatVectorOperations::copy(line, samples + firstPart, numToWrite - firstPart);
+        }
+
+        advance(numSamples);
+    }
+
+private:
+    void advance(size_t numSamples) noexcept
+    {
+        writeIndex = static_cast<int>((static_cast<size_t>(writeIndex) + numSamples) & static_cast<size_t>(mask));
+    }
+
+    juce::AudioBuffer<SampleType> lines;
+    int writeIndex = 0, mask = 0, delaySamples = 0;
+};
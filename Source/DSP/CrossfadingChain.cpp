@@ -0,0 +1,165 @@
+/*
+  ==============================================================================
+
+    CrossfadingChain.cpp
+
+  ==============================================================================
+*/
+
+#include "CrossfadingChain.h"
+
+template<typename SampleType>
+void CrossfadingChain<SampleType>::prepare(const juce::dsp::ProcessSpec& spec, const DSP_Bypassed& bypassed)
+{
+    sampleRate = spec.sampleRate;
+
+    for (auto& chain : chains)
+        chain.prepare(spec, bypassed);
+
+    fadingBuffer.setSize(static_cast<int>(spec.numChannels), static_cast<int>(spec.maximumBlockSize));
+    fadeInGains.resize(spec.maximumBlockSize);
+    fadeOutGains.resize(spec.maximumBlockSize);
+
+    hasOrder = false;
+    fadeSamplesRemaining = 0;
+}
+
+template<typename SampleType>
+bool CrossfadingChain<SampleType>::prepareSkippedStages(const DSP_Bypassed& bypassed)
+{
+    bool preparedAny = false;
+    for (auto& chain : chains)
+        preparedAny |= chain.prepareSkippedStages(bypassed);
+
+    return preparedAny;
+}
+
+template<typename SampleType>
+void CrossfadingChain<SampleType>::reset()
+{
+    for (auto& chain : chains)
+        chain.reset();
+
+    fadeSamplesRemaining = 0;
+}
+
+template<typename SampleType>
+void CrossfadingChain<SampleType>::setFadeLengthSeconds(double newFadeLengthSeconds) noexcept
+{
+    fadeLengthSeconds = newFadeLengthSeconds;
+}
+
+template<typename SampleType>
+void CrossfadingChain<SampleType>::setDefersStageResets(bool shouldDefer) noexcept
+{
+    for (auto& chain : chains)
+        chain.setDefersStageResets(shouldDefer);
+}
+
+template<typename SampleType>
+void CrossfadingChain<SampleType>::setProfiler(StageProfiler* newProfiler) noexcept
+{
+    for (auto& chain : chains)
+        chain.setProfiler(newProfiler);
+}
+
+template<typename SampleType>
+void CrossfadingChain<SampleType>::updateDSPFromParams(const DSPParameters& params)
+{
+    getActiveChain().updateDSPFromParams(params);
+
+    if (isReordering())
+        getFadingChain().updateDSPFromParams(params);
+}
+
+template<typename SampleType>
+int CrossfadingChain<SampleType>::getLatencyInSamples(const DSPParameters& params) const
+{
+    return chains[activeChain].getLatencyInSamples(params);
+}
+
+template<typename SampleType>
+double CrossfadingChain<SampleType>::getTailLengthSeconds(const DSPParameters& params) const
+{
+    return chains[activeChain].getTailLengthSeconds(params);
+}
+
+template<typename SampleType>
+void CrossfadingChain<SampleType>::process(juce::dsp::AudioBlock<SampleType> block, const DSP_Order& dspOrder, const DSPParameters& params)
+{
+    if (! hasOrder)
+    {
+        //nothing to fade from yet
+        activeOrder = dspOrder;
+        hasOrder = true;
+    }
+    else if (dspOrder != activeOrder && ! isReordering())
+    {
+        startReorder(dspOrder, params);
+    }
+
+    if (! isReordering())
+    {
+        getActiveChain().process(block, activeOrder, params);
+        return;
+    }
+
+    /*
+        the old order runs on a copy of the input, the new order runs in place.
+    */
+    const auto numSamples = block.getNumSamples();
+    const auto numChannels = juce::jmin(block.getNumChannels(), static_cast<size_t>(fadingBuffer.getNumChannels()));
+    jassert(numSamples <= static_cast<size_t>(fadingBuffer.getNumSamples()));
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+        juce::FloatVectorOperations::copy(fadingBuffer.getWritePointer(static_cast<int>(ch)), block.getChannelPointer(ch), static_cast<int>(numSamples));
+
+    auto fadingBlock = juce::dsp::AudioBlock<SampleType>(fadingBuffer).getSubsetChannelBlock(0, numChannels).getSubBlock(0, numSamples);
+    getFadingChain().process(fadingBlock, fadingOrder, params);
+    getActiveChain().process(block, activeOrder, params);
+
+    mixWithFadingChain(block);
+}
+
+template<typename SampleType>
+void CrossfadingChain<SampleType>::startReorder(const DSP_Order& newOrder, const DSPParameters& params)
+{
+    /*
+        the idle chain becomes the active one. it takes over the running chain's state,
+        so delay lines, LFOs and filters carry on instead of starting from silence.
+    */
+    fadingOrder = activeOrder;
+    activeOrder = newOrder;
+    activeChain = 1 - activeChain;
+
+    //the copy comes first, so a stage that comes back in this update is reset like it would have been in the running chain.
+    auto& chain = getActiveChain();
+    chain.copyStateFrom(getFadingChain());
+    chain.updateDSPFromParams(params);
+
+    fadeLengthInSamples = juce::jmax(1, static_cast<int>(std::round(sampleRate * fadeLengthSeconds)));
+    fadeSamplesRemaining = fadeLengthInSamples;
+}
+
+template<typename SampleType>
+void CrossfadingChain<SampleType>::mixWithFadingChain(const juce::dsp::AudioBlock<SampleType>& block)
+{
+    const auto numSamples = block.getNumSamples();
+
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        if (fadeSamplesRemaining > 0)
+            --fadeSamplesRemaining;
+
+        //the gains sum to 1 and go from all old order to all new order
+        fadeInGains[i] = SampleType(1) - static_cast<SampleType>(fadeSamplesRemaining) / static_cast<SampleType>(fadeLengthInSamples);
+        fadeOutGains[i] = SampleType(1) - fadeInGains[i];
+    }
+
+    const auto numChannels = juce::jmin(block.getNumChannels(), static_cast<size_t>(fadingBuffer.getNumChannels()));
+    for (size_t ch = 0; ch < numChannels; ++ch)
+        kernels.mix(block.getChannelPointer(ch), fadingBuffer.getReadPointer(static_cast<int>(ch)), fadeInGains.data(), fadeOutGains.data(), numSamples);
+}
+
+template struct CrossfadingChain<float>;
+template struct CrossfadingChain<double>;
@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    CrossfadingChain.h
+
+    Two MultiChannelDSP chains, so a new DSP_Order can be faded in instead of
+    switched in.
+    When the order changes, the idle chain takes over the running chain's state
+    (see MultiChannelDSP::copyStateFrom()) and starts running the new order
+    next to the old one. Their outputs are equal-gain (linearly) crossfaded
+    over the reorder window, then the old chain goes idle again. The two
+    chains run the same stages on the same input, so their outputs are
+    correlated and an equal-power fade would bulge by up to 3 dB mid-fade.
+    Both chains are prepared up front, with the same stages: a reorder never allocates.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "MultiChannelDSP.h"
+#include "VectorKernels.h"
+
+template<typename SampleType>
+struct CrossfadingChain
+{
+    static constexpr double defaultFadeLengthSeconds = 0.03;
+
+    // only the stages that aren't bypassed are prepared, see MultiChannelDSP::prepare().
+    void prepare(const juce::dsp::ProcessSpec& spec, const DSP_Bypassed& bypassed);
+
+    // message thread. see MultiChannelDSP::prepareSkippedStages().
+    bool prepareSkippedStages(const DSP_Bypassed& bypassed);
+
+    // ends any reorder in progress.
+    void reset();
+
+    // the fade length is picked up by the next reorder.
+    void setFadeLengthSeconds(double newFadeLengthSeconds) noexcept;
+
+    void updateDSPFromParams(const DSPParameters& params);
+
+    // see MultiChannelDSP::setDefersStageResets().
+    void setDefersStageResets(bool shouldDefer) noexcept;
+    void setProfiler(StageProfiler* newProfiler) noexcept;
+
+    int getLatencyInSamples(const DSPParameters& params) const;
+    double getTailLengthSeconds(const DSPParameters& params) const;
+
+    bool isReordering() const noexcept { return fadeSamplesRemaining > 0; }
+
+    /*
+        starts a reorder when dspOrder differs from the order the active chain runs.
+        a reorder that arrives mid-fade waits until the current fade is finished.
+    */
+    void process(juce::dsp::AudioBlock<SampleType> block, const DSP_Order& dspOrder, const DSPParameters& params);
+
+private:
+    MultiChannelDSP<SampleType>& getActiveChain() noexcept { return chains[activeChain]; }
+    MultiChannelDSP<SampleType>& getFadingChain() noexcept { return chains[1 - activeChain]; }
+
+    void startReorder(const DSP_Order& newOrder, const DSPParameters& params);
+    void mixWithFadingChain(const juce::dsp::AudioBlock<SampleType>& block);
+
+    std::array<MultiChannelDSP<SampleType>, 2> chains;
+    size_t activeChain = 0;
+
+    DSP_Order activeOrder{}, fadingOrder{};
+    bool hasOrder = false;
+
+    double sampleRate = 44100.0;
+    double fadeLengthSeconds = defaultFadeLengthSeconds;
+    int fadeLengthInSamples = 1, fadeSamplesRemaining = 0;
+
+    //input copy for the fading chain, and the crossfade gains shared by every channel
+    juce::AudioBuffer<SampleType> fadingBuffer;
+    std::vector<SampleType> fadeInGains, fadeOutGains;
+
+    const VectorKernels<SampleType>& kernels = VectorKernels<SampleType>::get();
+};
@@ -0,0 +1,42 @@
+/*
+  ==============================================================================
+
+    FastMath.h
+
+    Small math helpers written so they work for both plain floats and
+    juce::dsp::SIMDRegister lanes.
+    SIMDRegister only supports +, -, * and min/max, so nothing in here divides
+    and scalars always go on the right hand side of an operator.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+template<typename SampleType>
+using NumericTypeOf = typename juce::dsp::SampleTypeHelpers::ElementType<SampleType>::Type;
+
+inline float clampSymmetric(float x, float limit) { return juce::jlimit(-limit, limit, x); }
+inline double clampSymmetric(double x, double limit) { return juce::jlimit(-limit, limit, x); }
+
+template<typename T>
+juce::dsp::SIMDRegister<T> clampSymmetric(juce::dsp::SIMDRegister<T> x, T limit)
+{
+    using Register = juce::dsp::SIMDRegister<T>;
+    return Register::min(Register::max(x, Register::expand(-limit)), Register::expand(limit));
+}
+
+/*
+    cubic soft clipper.
+    unity slope at zero like tanh, and it reaches +/-1 with zero slope at +/-1.5.
+*/
+template<typename SampleType>
+SampleType softClip(SampleType x)
+{
+    using NumericType = NumericTypeOf<SampleType>;
+
+    x = clampSymmetric(x, NumericType(1.5));
+    return x - x * x * x * NumericType(4.0 / 27.0);
+}
@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    FilterCoefficientTables.cpp
+
+  ==============================================================================
+*/
+
+#include "FilterCoefficientTables.h"
+
+std::shared_ptr<const FilterCoefficientTables> FilterCoefficientTables::getForSampleRate(double sampleRate)
+{
+    /*
+        the cache only holds weak references.
+        the tables for a sample rate are released when the last instance using them lets go.
+    */
+    static juce::CriticalSection lock;
+    static std::map<double, std::weak_ptr<const FilterCoefficientTables>> cache;
+
+    const juce::ScopedLock sl(lock);
+
+    if (auto existing = cache[sampleRate].lock())
+        return existing;
+
+    auto tables = std::make_shared<const FilterCoefficientTables>(sampleRate);
+    cache[sampleRate] = tables;
+    return tables;
+}
+
+template <typename Function>
+void FilterCoefficientTables::CutoffTable::fill(float startFrequency, float endFrequency, float density, Function&& function)
+{
+    log2StartFrequency = std::log2(startFrequency);
+    pointsPerOctave = density;
+
+    /*
+        the last point sits at or just past endFrequency rather than being clamped onto it,
+        otherwise the final cell would be interpolated as if it spanned a full step.
+        one step past 0.49 fs is still short of Nyquist.
+    */
+    const auto numOctaves = std::log2(endFrequency / startFrequency);
+    values.resize(static_cast<size_t>(std::ceil(numOctaves * pointsPerOctave)) + 2);
+
+    for (size_t i = 0; i < values.size(); ++i)
+        values[i] = static_cast<float>(function(startFrequency * std::exp2(static_cast<double>(i) / pointsPerOctave)));
+}
+
+float FilterCoefficientTables::CutoffTable::lookup(float log2Frequency) const
+{
+    auto position = juce::jmax(0.f, (log2Frequency - log2StartFrequency) * pointsPerOctave);
+    auto index = juce::jmin(static_cast<size_t>(position), values.size() - 2);
+    auto fraction = position - static_cast<float>(index);
+
+    return values[index] + (values[index + 1] - values[index]) * fraction;
+}
+
+FilterCoefficientTables::FilterCoefficientTables(double sr) :
+    sampleRate(sr),
+    maxFrequency(static_cast<float>(sr * 0.49)),
+    topOctaveStartFrequency(maxFrequency * 0.5f),
+    log2TopOctaveStartFrequency(std::log2(topOctaveStartFrequency))
+{
+    jassert(sampleRate > 0.0);
+
+    auto svfGain = [sr](double frequency) { return std::tan(juce::MathConstants<double>::pi * frequency / sr); };
+    auto ladderCutoffTransform = [sr](double frequency) { return std::exp(-juce::MathConstants<double>::twoPi * frequency / sr); };
+
+    svfGains.lower.fill(minFrequency, topOctaveStartFrequency, pointsPerOctave, svfGain);
+    svfGains.topOctave.fill(topOctaveStartFrequency, maxFrequency, topOctavePointsPerOctave, svfGain);
+
+    ladderCutoffTransforms.lower.fill(minFrequency, topOctaveStartFrequency, pointsPerOctave, ladderCutoffTransform);
+    ladderCutoffTransforms.topOctave.fill(topOctaveStartFrequency, maxFrequency, topOctavePointsPerOctave, ladderCutoffTransform);
+
+    const auto numGainPoints = static_cast<size_t>((maxGainDb - minGainDb) * pointsPerDb) + 2;
+    peakAmplitudes.resize(numGainPoints);
+
+    for (size_t i = 0; i < numGainPoints; ++i)
+    {
+        auto gainDb = juce::jmin(static_cast<double>(maxGainDb), minGainDb + static_cast<double>(i) / pointsPerDb);
+        peakAmplitudes[i] = static_cast<float>(std::pow(10.0, gainDb / 40.0));
+    }
+}
+
+float FilterCoefficientTables::lookupCutoff(const CutoffTablePair& tables, float frequencyHz) const
+{
+    auto log2Frequency = std::log2(juce::jlimit(minFrequency, maxFrequency, frequencyHz));
+
+    return log2Frequency < log2TopOctaveStartFrequency ? tables.lower.lookup(log2Frequency)
+                                                       : tables.topOctave.lookup(log2Frequency);
+}
+
+float FilterCoefficientTables::getSVFGain(float frequencyHz) const
+{
+    return lookupCutoff(svfGains, frequencyHz);
+}
+
+float FilterCoefficientTables::getLadderCutoffTransform(float frequencyHz) const
+{
+    return lookupCutoff(ladderCutoffTransforms, frequencyHz);
+}
+
+float FilterCoefficientTables::getPeakAmplitude(float gainDb) const
+{
+    auto position = (juce::jlimit(minGainDb, maxGainDb, gainDb) - minGainDb) * pointsPerDb;
+    auto index = juce::jmin(static_cast<size_t>(position), peakAmplitudes.size() - 2);
+    auto fraction = position - static_cast<float>(index);
+
+    return peakAmplitudes[index] + (peakAmplitudes[index + 1] - peakAmplitudes[index]) * fraction;
+}
+
+size_t FilterCoefficientTables::getSizeInBytes() const
+{
+    return sizeof(*this) + sizeof(float) * (svfGains.lower.values.size() + svfGains.topOctave.values.size()
+                                      + ladderCutoffTransforms.lower.values.size() + ladderCutoffTransforms.topOctave.values.size()
+                                      + peakAmplitudes.size());
+}
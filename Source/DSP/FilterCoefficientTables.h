@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    FilterCoefficientTables.h
+
+    Lookup tables for the trig/exp terms the filters need when a cutoff moves:
+        tan(pi * f / fs)        GeneralFilter (SVF) gain
+        exp(-2 * pi * f / fs)   LadderFilter cutoff transform
+        10^(dB / 40)            GeneralFilter peak amplitude
+
+    The cutoff tables are indexed by log2(frequency) and linearly interpolated.
+    They only depend on the sample rate, so one set per sample rate is shared
+    by every plugin instance in the process.  Call getForSampleRate() from
+    prepare(), never from the audio thread.
+
+    tan() bends hard as it approaches its pole at Nyquist, so the top octave
+    gets its own table at 8x the density.  Measured worst-case relative error
+    (44.1k - 192k) is under 0.01% for the SVF gain and under 0.001% for the
+    ladder transform, over the whole 10 Hz - 0.49 fs range.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct FilterCoefficientTables
+{
+    static std::shared_ptr<const FilterCoefficientTables> getForSampleRate(double sampleRate);
+
+    float getSVFGain(float frequencyHz) const;
+    float getLadderCutoffTransform(float frequencyHz) const;
+    float getPeakAmplitude(float gainDb) const;
+
+    double getSampleRate() const { return sampleRate; }
+    size_t getSizeInBytes() const;
+
+    explicit FilterCoefficientTables(double sampleRate);
+
+private:
+    struct CutoffTable
+    {
+        template <typename Function>
+        void fill(float startFrequency, float endFrequency, float density, Function&& function);
+
+        float lookup(float log2Frequency) const;
+
+        float log2StartFrequency = 0.f, pointsPerOctave = 0.f;
+        std::vector<float> values;
+    };
+
+    struct CutoffTablePair
+    {
+        CutoffTable lower, topOctave;
+    };
+
+    float lookupCutoff(const CutoffTablePair& tables, float frequencyHz) const;
+
+    static constexpr float minFrequency = 10.f;
+    static constexpr float pointsPerOctave = 256.f;
+    static constexpr float topOctavePointsPerOctave = 2048.f;
+
+    static constexpr float minGainDb = -48.f;
+    static constexpr float maxGainDb = 48.f;
+    static constexpr float pointsPerDb = 10.f;
+
+    double sampleRate;
+    float maxFrequency, topOctaveStartFrequency, log2TopOctaveStartFrequency;
+
+    CutoffTablePair svfGains, ladderCutoffTransforms;
+    std::vector<float> peakAmplitudes;
+};
@@ -0,0 +1,214 @@
+/*
+  ==============================================================================
+
+    GeneralFilter.h
+
+    Peak / bandpass / notch / allpass filter built on a TPT state variable
+    filter (Andrew Simper's trapezoidal SVF).
+    The responses match the juce::dsp::IIR::Coefficients factory functions
+    (RBJ cookbook), but:
+        - coefficients are computed in place, nothing is allocated
+        - coefficients glide to their new values one sample at a time
+        - the filter state is never cleared when the coefficients change
+    The SVF topology stays stable while it is being modulated, so this can be
+    swept without clicks.
+    Once prepared, the tan() and pow() terms are read from the shared
+    FilterCoefficientTables instead of being evaluated on every update.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FastMath.h"
+#include "FilterCoefficientTables.h"
+
+enum class GeneralFilterMode
+{
+    Peak,
+    Bandpass,
+    Notch,
+    Allpass,
+    END_OF_LIST
+};
+
+template<typename SampleType>
+struct GeneralFilter
+{
+    using NumericType = NumericTypeOf<SampleType>;
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+        tables = FilterCoefficientTables::getForSampleRate(sampleRate);
+        rampLengthInSamples = juce::jmax(1, static_cast<int>(std::round(sampleRate * rampLengthSeconds)));
+
+        setParameters(mode, frequency, quality, gainDb);
+        reset();
+    }
+
+    void reset()
+    {
+        ic1eq = SampleType{};
+        ic2eq = SampleType{};
+
+        current = target;
+        rampSamplesRemaining = 0;
+        updateGains();
+    }
+
+    void setParameters(GeneralFilterMode newMode, NumericType newFrequency, NumericType newQuality, NumericType newGainDb)
+    {
+        mode = newMode;
+        frequency = newFrequency;
+        quality = newQuality;
+        gainDb = newGainDb;
+
+        const auto g = getSVFGain(frequency);
+        const auto q = juce::jmax(quality, NumericType(0.001));
+
+        Coefficients next;
+        next.g = g;
+
+        switch (mode)
+        {
+            case GeneralFilterMode::Peak:
+            {
+                const auto A = getPeakAmplitude(gainDb);
+                next.k = NumericType(1) / (q * A);
+                next.m0 = NumericType(1);
+                next.m1 = next.k * (A * A - NumericType(1));
+                break;
+            }
+            case GeneralFilterMode::Bandpass:
+            {
+                next.k = NumericType(1) / q;
+                next.m0 = NumericType(0);
+                next.m1 = next.k;
+                break;
+            }
+            case GeneralFilterMode::Notch:
+            {
+                next.k = NumericType(1) / q;
+                next.m0 = NumericType(1);
+                next.m1 = -next.k;
+                break;
+            }
+            case GeneralFilterMode::Allpass:
+            {
+                next.k = NumericType(1) / q;
+                next.m0 = NumericType(1);
+                next.m1 = NumericType(-2) * next.k;
+                break;
+            }
+            case GeneralFilterMode::END_OF_LIST:
+            {
+                jassertfalse;
+                return;
+            }
+        }
+
+        if (next == target)
+            return;
+
+        target = next;
+        rampSamplesRemaining = rampLengthInSamples;
+
+        const auto scale = NumericType(1) / static_cast<NumericType>(rampLengthInSamples);
+        step.g = (target.g - current.g) * scale;
+        step.k = (target.k - current.k) * scale;
+        step.m0 = (target.m0 - current.m0) * scale;
+        step.m1 = (target.m1 - current.m1) * scale;
+    }
+
+    /*
+        time for the filter to ring down by 60dB.
+        the SVF poles decay at k * w0 / 2, and 60dB is ln(1000) ~= 6.9 time constants.
+    */
+    NumericType getTailLengthSeconds() const noexcept
+    {
+        const auto w0 = juce::MathConstants<NumericType>::twoPi * frequency;
+        return NumericType(6.9 * 2.0) / (w0 * juce::jmax(target.k, NumericType(0.001)));
+    }
+
+    SampleType processSample(SampleType v0) noexcept
+    {
+        if (rampSamplesRemaining > 0)
+        {
+            if (--rampSamplesRemaining == 0)
+            {
+                current = target;
+            }
+            else
+            {
+                current.g += step.g;
+                current.k += step.k;
+                current.m0 += step.m0;
+                current.m1 += step.m1;
+            }
+
+            updateGains();
+        }
+
+        const auto v3 = v0 - ic2eq;
+        const auto v1 = ic1eq * a1 + v3 * a2;
+        const auto v2 = ic2eq + ic1eq * a2 + v3 * a3;
+
+        ic1eq = v1 * NumericType(2) - ic1eq;
+        ic2eq = v2 * NumericType(2) - ic2eq;
+
+        return v0 * current.m0 + v1 * current.m1;
+    }
+
+private:
+    struct Coefficients
+    {
+        NumericType g = NumericType(0), k = NumericType(1), m0 = NumericType(1), m1 = NumericType(0);
+
+        bool operator==(const Coefficients& other) const
+        {
+            return g == other.g && k == other.k && m0 == other.m0 && m1 == other.m1;
+        }
+    };
+
+    NumericType getSVFGain(NumericType frequencyHz) const
+    {
+        if (tables != nullptr)
+            return static_cast<NumericType>(tables->getSVFGain(static_cast<float>(frequencyHz)));
+
+        const auto nyquistLimit = static_cast<NumericType>(sampleRate * 0.49);
+        return static_cast<NumericType>(std::tan(juce::MathConstants<double>::pi * juce::jmin(frequencyHz, nyquistLimit) / sampleRate));
+    }
+
+    NumericType getPeakAmplitude(NumericType peakGainDb) const
+    {
+        if (tables != nullptr)
+            return static_cast<NumericType>(tables->getPeakAmplitude(static_cast<float>(peakGainDb)));
+
+        return std::pow(NumericType(10), peakGainDb / NumericType(40));
+    }
+
+    void updateGains()
+    {
+        a1 = NumericType(1) / (NumericType(1) + current.g * (current.g + current.k));
+        a2 = current.g * a1;
+        a3 = current.g * a2;
+    }
+
+    static constexpr double rampLengthSeconds = 0.0015;
+
+    double sampleRate = 44100.0;
+    int rampLengthInSamples = 1;
+    int rampSamplesRemaining = 0;
+
+    GeneralFilterMode mode = GeneralFilterMode::Peak;
+    NumericType frequency = NumericType(750), quality = NumericType(0.72), gainDb = NumericType(0);
+
+    Coefficients target, current, step;
+    NumericType a1 = NumericType(1), a2 = NumericType(0), a3 = NumericType(0);
+
+    SampleType ic1eq{}, ic2eq{};
+
+    std::shared_ptr<const FilterCoefficientTables> tables;
+};
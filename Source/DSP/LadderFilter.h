@@ -0,0 +1,167 @@
+/*
+  ==============================================================================
+
+    LadderFilter.h
+
+    Port of juce::dsp::LadderFilter that can run on juce::dsp::SIMDRegister
+    lanes, so several channels share one pass of the filter.
+    The tanh saturation lookup table is replaced with softClip(), because the
+    lookup table can't be evaluated on a SIMD register.
+    The cutoff transform comes from the shared FilterCoefficientTables once
+    the filter has been prepared.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FastMath.h"
+#include "FilterCoefficientTables.h"
+
+template<typename SampleType>
+struct LadderFilter
+{
+    using NumericType = NumericTypeOf<SampleType>;
+    using Mode = juce::dsp::LadderFilterMode;
+
+    LadderFilter()
+    {
+        setSampleRate(NumericType(1000));
+        setResonance(NumericType(0));
+        setDrive(NumericType(1.2));
+        setMode(Mode::LPF12);
+    }
+
+    /*
+        the spec's channel count is ignored: one SampleType already holds every channel this filter processes.
+    */
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        tables = FilterCoefficientTables::getForSampleRate(spec.sampleRate);
+        setSampleRate(NumericType(spec.sampleRate));
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        state.fill(SampleType{});
+
+        cutoffTransformSmoother.setCurrentAndTargetValue(cutoffTransformSmoother.getTargetValue());
+        scaledResonanceSmoother.setCurrentAndTargetValue(scaledResonanceSmoother.getTargetValue());
+    }
+
+    void setMode(Mode newMode) noexcept
+    {
+        switch (newMode)
+        {
+            case Mode::LPF12:   A = {{ NumericType(0),  NumericType(0),  NumericType(1),  NumericType(0),  NumericType(0) }}; comp = NumericType(0.5);  break;
+            case Mode::HPF12:   A = {{ NumericType(1),  NumericType(-2), NumericType(1),  NumericType(0),  NumericType(0) }}; comp = NumericType(0);    break;
+            case Mode::BPF12:   A = {{ NumericType(0),  NumericType(0),  NumericType(-1), NumericType(1),  NumericType(0) }}; comp = NumericType(0.5);  break;
+            case Mode::LPF24:   A = {{ NumericType(0),  NumericType(0),  NumericType(0),  NumericType(0),  NumericType(1) }}; comp = NumericType(0.5);  break;
+            case Mode::HPF24:   A = {{ NumericType(1),  NumericType(-4), NumericType(6),  NumericType(-4), NumericType(1) }}; comp = NumericType(0);    break;
+            case Mode::BPF24:   A = {{ NumericType(0),  NumericType(0),  NumericType(1),  NumericType(-2), NumericType(1) }}; comp = NumericType(0.5);  break;
+            default:            jassertfalse;                                                                                                        break;
+        }
+
+        for (auto& a : A)
+            a *= NumericType(1.2);
+
+        mode = newMode;
+    }
+
+    void setCutoffFrequencyHz(NumericType newCutoff) noexcept
+    {
+        jassert(newCutoff > NumericType(0));
+        cutoffFreqHz = newCutoff;
+
+        if (tables != nullptr)
+            cutoffTransformSmoother.setTargetValue(static_cast<NumericType>(tables->getLadderCutoffTransform(static_cast<float>(cutoffFreqHz))));
+        else
+            cutoffTransformSmoother.setTargetValue(std::exp(cutoffFreqHz * cutoffFreqScaler));
+    }
+
+    void setResonance(NumericType newResonance) noexcept
+    {
+        jassert(newResonance >= NumericType(0) && newResonance <= NumericType(1));
+        resonance = newResonance;
+        scaledResonanceSmoother.setTargetValue(juce::jmap(resonance, NumericType(0.1), NumericType(1.0)));
+    }
+
+    void setDrive(NumericType newDrive) noexcept
+    {
+        jassert(newDrive >= NumericType(1));
+
+        if (newDrive == drive)
+            return;
+
+        drive = newDrive;
+        gain = std::pow(drive, NumericType(-2.642)) * NumericType(0.6103) + NumericType(0.3903);
+        drive2 = drive * NumericType(0.04) + NumericType(0.96);
+        gain2 = std::pow(drive2, NumericType(-2.642)) * NumericType(0.6103) + NumericType(0.3903);
+    }
+
+    // time for the ladder to ring down by 60dB. more resonance means less damping and a longer ring.
+    NumericType getTailLengthSeconds() const noexcept
+    {
+        const auto scaledResonance = juce::jmap(resonance, NumericType(0.1), NumericType(1.0));
+        const auto damping = juce::jmax(NumericType(1) - scaledResonance, NumericType(0.01));
+
+        return NumericType(6.9) / (juce::MathConstants<NumericType>::twoPi * cutoffFreqHz * damping);
+    }
+
+    SampleType processSample(SampleType inputValue) noexcept
+    {
+        const auto a1 = cutoffTransformSmoother.getNextValue();
+        const auto scaledResonance = scaledResonanceSmoother.getNextValue();
+
+        const auto g = a1 * NumericType(-1) + NumericType(1);
+        const auto b0 = g * NumericType(0.76923076923);
+        const auto b1 = g * NumericType(0.23076923076);
+
+        auto& s = state;
+
+        const auto dx = softClip(inputValue * drive) * gain;
+        const auto a = dx + (softClip(s[4] * drive2) * gain2 - dx * comp) * (scaledResonance * NumericType(-4));
+
+        const auto b = s[0] * b1 + s[1] * a1 + a * b0;
+        const auto c = s[1] * b1 + s[2] * a1 + b * b0;
+        const auto d = s[2] * b1 + s[3] * a1 + c * b0;
+        const auto e = s[3] * b1 + s[4] * a1 + d * b0;
+
+        s[0] = a;
+        s[1] = b;
+        s[2] = c;
+        s[3] = d;
+        s[4] = e;
+
+        return a * A[0] + b * A[1] + c * A[2] + d * A[3] + e * A[4];
+    }
+
+private:
+    void setSampleRate(NumericType newValue) noexcept
+    {
+        jassert(newValue > NumericType(0));
+        cutoffFreqScaler = NumericType(-2.0 * juce::MathConstants<double>::pi) / newValue;
+
+        static constexpr NumericType smootherRampTimeSec = NumericType(0.05);
+        cutoffTransformSmoother.reset(newValue, smootherRampTimeSec);
+        scaledResonanceSmoother.reset(newValue, smootherRampTimeSec);
+
+        setCutoffFrequencyHz(cutoffFreqHz);
+    }
+
+    static constexpr size_t numStates = 5;
+    std::array<SampleType, numStates> state{};
+    std::array<NumericType, numStates> A{};
+
+    juce::SmoothedValue<NumericType> cutoffTransformSmoother, scaledResonanceSmoother;
+
+    NumericType drive{}, drive2{}, gain{}, gain2{}, comp{};
+    NumericType cutoffFreqHz{ 200 };
+    NumericType resonance{};
+    NumericType cutoffFreqScaler{};
+    Mode mode;
+
+    std::shared_ptr<const FilterCoefficientTables> tables;
+};
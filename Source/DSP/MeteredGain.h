@@ -0,0 +1,315 @@
+/*
+  ==============================================================================
+
+    MeteredGain.h
+
+    Applies a gain and measures the result in the same loop, so metering
+    doesn't need its own passes over the buffer.
+    Gain changes ramp linearly (in linear gain, not dB) one sample at a time,
+    so a ramp sounds the same whatever the host block size is.
+    Per channel it measures:
+        RMS         sqrt(mean(x^2)) since startMeasurement()
+        peak        max |x|
+        true peak   max |x| of the 4x oversampled signal (ITU-R BS.1770 style,
+                    4 phase, 12 taps per phase windowed-sinc interpolation)
+    The gain, RMS and peak run on SIMDRegister lanes in one pass. The true
+    peak interpolator then runs over the whole block at once, one phase and
+    one tap at a time, reading a history buffer that holds the last block's
+    tail followed by this block.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+template<typename SampleType>
+struct MeteredGain
+{
+    struct Measurement
+    {
+        SampleType rms = SampleType(0), peak = SampleType(0), truePeak = SampleType(0);
+    };
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        maxBlockSize = juce::jmax(static_cast<size_t>(spec.maximumBlockSize), size_t(1));
+        interpolated.resize(maxBlockSize);
+
+        channels.resize(spec.numChannels);
+        for (auto& channel : channels)
+            channel.history.resize(historyLength + maxBlockSize);
+
+        rampLengthInSamples = juce::jmax(1, static_cast<int>(std::round(spec.sampleRate * rampLengthSeconds)));
+        reset();
+    }
+
+    // also snaps the gain to its target.
+    void reset()
+    {
+        currentGain = targetGain;
+        rampStartGain = targetGain;
+        gainStep = SampleType(0);
+        rampPosition = 0;
+        rampSamplesRemaining = 0;
+
+        for (auto& channel : channels)
+            std::fill(channel.history.begin(), channel.history.end(), SampleType(0));
+
+        startMeasurement();
+    }
+
+    // the dB -> gain conversion only happens when the target moves, never per sample.
+    void setGainDecibels(SampleType newGainDecibels) noexcept
+    {
+        if (newGainDecibels == targetGainDecibels)
+            return;
+
+        targetGainDecibels = newGainDecibels;
+        targetGain = juce::Decibels::decibelsToGain(newGainDecibels, SampleType(-100));
+
+        /*
+            every ramp gain is computed from the start of the ramp instead of accumulated,
+            so the output is bit-identical whatever block size the ramp gets split into.
+        */
+        rampStartGain = currentGain;
+        rampPosition = 0;
+        rampSamplesRemaining = rampLengthInSamples;
+        gainStep = (targetGain - rampStartGain) / static_cast<SampleType>(rampLengthInSamples);
+    }
+
+    // clears the accumulated measurements. call this once per host block.
+    void startMeasurement() noexcept
+    {
+        for (auto& channel : channels)
+        {
+            channel.sumOfSquares = SampleType(0);
+            channel.peak = SampleType(0);
+            channel.truePeak = SampleType(0);
+        }
+
+        numSamplesMeasured = 0;
+    }
+
+    void process(const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept
+    {
+        auto& block = context.getOutputBlock();
+        const auto numSamples = block.getNumSamples();
+        const auto numChannels = juce::jmin(block.getNumChannels(), channels.size());
+
+        jassert(block.getNumChannels() <= channels.size());
+
+        //every channel gets the same ramp, so the ramp only advances once all of them are done.
+        const auto numRampSamples = juce::jmin(numSamples, static_cast<size_t>(rampSamplesRemaining));
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+            processChannel(block.getChannelPointer(ch), numSamples, numRampSamples, channels[ch]);
+
+        numSamplesMeasured += numSamples;
+
+        if (numRampSamples > 0)
+        {
+            rampSamplesRemaining -= static_cast<int>(numRampSamples);
+            rampPosition += static_cast<int>(numRampSamples);
+            currentGain = rampSamplesRemaining > 0 ? rampStartGain + gainStep * static_cast<SampleType>(rampPosition)
+                                                   : targetGain;
+        }
+    }
+
+    //just the sample peak, without working out the RMS.
+    SampleType getPeak(size_t channel) const noexcept
+    {
+        return channel < channels.size() ? channels[channel].peak : SampleType(0);
+    }
+
+    Measurement getMeasurement(size_t channel) const noexcept
+    {
+        Measurement m;
+        if (channel >= channels.size())
+            return m;
+
+        const auto& state = channels[channel];
+
+        if (numSamplesMeasured > 0)
+            m.rms = std::sqrt(state.sumOfSquares / static_cast<SampleType>(numSamplesMeasured));
+
+        m.peak = state.peak;
+        m.truePeak = juce::jmax(state.peak, state.truePeak);
+        return m;
+    }
+
+private:
+    static constexpr size_t numPhases = 4;
+    static constexpr size_t tapsPerPhase = 12;
+
+    //the interpolator looks this many samples back from the first sample of a block.
+    static constexpr size_t historyLength = tapsPerPhase - 1;
+
+    using Lanes = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr size_t laneCount = Lanes::SIMDNumElements;
+
+    struct ChannelState
+    {
+        //the last historyLength samples of the previous block, then the current block.
+        std::vector<SampleType> history;
+
+        SampleType sumOfSquares = SampleType(0), peak = SampleType(0), truePeak = SampleType(0);
+    };
+
+    void processChannel(SampleType* samples, size_t numSamples, size_t numRampSamples, ChannelState& state) noexcept
+    {
+        applyGainAndMeasure(samples, 0, numRampSamples, true, state);
+        applyGainAndMeasure(samples, numRampSamples, numSamples, false, state);
+
+        //the history only has room for maxBlockSize samples at a time.
+        for (size_t start = 0; start < numSamples; start += maxBlockSize)
+            measureTruePeak(samples + start, juce::jmin(maxBlockSize, numSamples - start), state);
+    }
+
+    /*
+        scalar up to the first aligned sample, lanes through the middle, scalar for the tail.
+        a ramp gain is computed from its position the same way in both paths, so the output
+        doesn't depend on where the block happens to be aligned.
+    */
+    void applyGainAndMeasure(SampleType* samples, size_t begin, size_t end, bool ramping, ChannelState& state) noexcept
+    {
+        auto sumOfSquares = state.sumOfSquares;
+        auto peak = state.peak;
+
+        auto gainAt = [&](size_t i)
+        {
+            return ramping ? rampStartGain + gainStep * static_cast<SampleType>(rampPosition + static_cast<int>(i) + 1)
+                           : targetGain;
+        };
+
+        auto processSample = [&](size_t i)
+        {
+            const auto y = samples[i] * gainAt(i);
+            samples[i] = y;
+
+            sumOfSquares += y * y;
+            peak = juce::jmax(peak, std::abs(y));
+        };
+
+        auto i = begin;
+        const auto firstAligned = static_cast<size_t>(Lanes::getNextSIMDAlignedPtr(samples + begin) - samples);
+
+        for (; i < juce::jmin(end, firstAligned); ++i)
+            processSample(i);
+
+        if (i + laneCount <= end)
+        {
+            auto laneOffsets = Lanes::expand(SampleType(0));
+            for (size_t lane = 0; lane < laneCount; ++lane)
+                laneOffsets.set(lane, static_cast<SampleType>(lane + 1));
+
+            auto sumLanes = Lanes::expand(SampleType(0));
+            auto peakLanes = Lanes::expand(SampleType(0));
+
+            for (; i + laneCount <= end; i += laneCount)
+            {
+                auto gain = Lanes::expand(targetGain);
+                if (ramping)
+                    gain = Lanes::expand(gainStep) * (laneOffsets + static_cast<SampleType>(rampPosition + static_cast<int>(i)))
+                           + rampStartGain;
+
+                const auto y = Lanes::fromRawArray(samples + i) * gain;
+                y.copyToRawArray(samples + i);
+
+                sumLanes += y * y;
+                peakLanes = Lanes::max(peakLanes, Lanes::abs(y));
+            }
+
+            sumOfSquares += sumLanes.sum();
+            for (size_t lane = 0; lane < laneCount; ++lane)
+                peak = juce::jmax(peak, peakLanes.get(lane));
+        }
+
+        for (; i < end; ++i)
+            processSample(i);
+
+        state.sumOfSquares = sumOfSquares;
+        state.peak = peak;
+    }
+
+    void measureTruePeak(const SampleType* samples, size_t numSamples, ChannelState& state) noexcept
+    {
+        auto* history = state.history.data();
+        const auto count = static_cast<int>(numSamples);
+
+        juce::FloatVectorOperations::copy(history + historyLength, samples, count);
+
+        //phase 0 is the sample itself, which the peak already covers.
+        for (size_t phase = 1; phase < numPhases; ++phase)
+        {
+            const auto& taps = interpolationTaps[phase];
+
+            juce::FloatVectorOperations::clear(interpolated.data(), count);
+            for (size_t k = 0; k < tapsPerPhase; ++k)
+                juce::FloatVectorOperations::addWithMultiply(interpolated.data(), history + k, taps[k], count);
+
+            const auto range = juce::FloatVectorOperations::findMinAndMax(interpolated.data(), count);
+            state.truePeak = juce::jmax(state.truePeak, -range.getStart(), range.getEnd());
+        }
+
+        //keep this block's tail for the next one. the ranges can overlap, but the copy runs forwards.
+        std::copy(history + numSamples, history + numSamples + historyLength, history);
+    }
+
+    using InterpolationTaps = std::array<std::array<SampleType, tapsPerPhase>, numPhases>;
+
+    //the taps never change, so every instance in the process shares one set.
+    static const InterpolationTaps& getInterpolationTaps()
+    {
+        static const auto taps = makeInterpolationTaps();
+        return taps;
+    }
+
+    static InterpolationTaps makeInterpolationTaps()
+    {
+        InterpolationTaps allTaps{};
+
+        const auto pi = juce::MathConstants<double>::pi;
+        const auto centre = static_cast<double>(tapsPerPhase) * 0.5 - 1.0;
+
+        for (size_t phase = 0; phase < numPhases; ++phase)
+        {
+            auto& taps = allTaps[phase];
+            const auto offset = centre + static_cast<double>(phase) / numPhases;
+
+            double sum = 0.0;
+            for (size_t k = 0; k < tapsPerPhase; ++k)
+            {
+                const auto x = static_cast<double>(k) - offset;
+                const auto sinc = std::abs(x) < 1e-9 ? 1.0 : std::sin(pi * x) / (pi * x);
+
+                //hann window over the whole 4x prototype filter
+                const auto n = static_cast<double>(k * numPhases) - (offset * numPhases) + (tapsPerPhase * numPhases) * 0.5;
+                const auto window = 0.5 - 0.5 * std::cos(2.0 * pi * n / (tapsPerPhase * numPhases));
+
+                taps[k] = sinc * window;
+                sum += taps[k];
+            }
+
+            //unity gain at DC for every phase
+            for (auto& tap : taps)
+                tap = static_cast<SampleType>(tap / sum);
+        }
+
+        return allTaps;
+    }
+
+    //looked up when the meter is constructed, so the audio thread never initialises it.
+    const InterpolationTaps& interpolationTaps = getInterpolationTaps();
+    std::vector<ChannelState> channels;
+    std::vector<SampleType> interpolated;
+    size_t maxBlockSize = 1, numSamplesMeasured = 0;
+
+    static constexpr double rampLengthSeconds = 0.02;
+    int rampLengthInSamples = 1, rampSamplesRemaining = 0, rampPosition = 0;
+
+    SampleType targetGainDecibels = SampleType(0);
+    SampleType targetGain = SampleType(1), currentGain = SampleType(1);
+    SampleType rampStartGain = SampleType(1), gainStep = SampleType(0);
+};
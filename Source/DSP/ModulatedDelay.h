@@ -0,0 +1,420 @@
+/*
+  ==============================================================================
+
+    ModulatedDelay.h
+
+    Feedback delay with a modulated, fractional read position.
+    The delay time glides towards its target one sample at a time, and a
+    sine LFO adds up to maxModulationDepthMs on top, so the read position
+    moves every sample whether or not anything is automated. Both
+    interpolators cost the same handful of multiplies at any position:
+    - Lagrange3rd: 4 taps, no state, follows fast modulation cleanly
+    - Thiran: 1st order allpass, flat magnitude, best for slow changes
+    The feedback path runs through a one-pole low cut and high cut.
+    In ping-pong mode channels are paired up (0/1, 2/3, ...): the sum of a
+    pair is fed into its first channel and each channel's echo feeds the
+    other, so the repeats bounce between the two.
+    The delay lines are sized for maxDelayMs in prepare(). Nothing the audio
+    thread calls allocates.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+enum class DelayInterpolation
+{
+    Lagrange3rd,
+    Thiran,
+    END_OF_LIST
+};
+
+template<typename SampleType>
+struct ModulatedDelay
+{
+    /*
+        long enough for the longest synced note (4 beats) down to 30 bpm.
+        the free delay time parameter only goes up to 2 s.
+    */
+    static constexpr SampleType minDelayMs = SampleType(1);
+    static constexpr SampleType maxDelayMs = SampleType(8000);
+    static constexpr SampleType maxModulationDepthMs = SampleType(10);
+
+    //time constant of the glide towards a new delay time. shorter sounds like a jump, longer like tape.
+    static constexpr double glideSeconds = 0.05;
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+
+        //a power of two, so wrapping the read and write positions is a mask. the 4 extra samples are the Lagrange taps.
+        const auto maxDelaySamples = static_cast<int>(std::ceil((maxDelayMs + maxModulationDepthMs) * 0.001 * sampleRate)) + 4;
+        const auto lineLength = juce::nextPowerOfTwo(maxDelaySamples);
+        lines.setSize(static_cast<int>(spec.numChannels), lineLength);
+        mask = lineLength - 1;
+
+        channels.resize(spec.numChannels);
+        updateRouting();
+
+        glideCoefficient = static_cast<SampleType>(1.0 - std::exp(-1.0 / (glideSeconds * sampleRate)));
+
+        //force the coefficients to be recalculated for the new sample rate
+        lowCutHz = highCutHz = modulationRateHz = SampleType(-1);
+        setFeedbackFilter(targetLowCutHz, targetHighCutHz);
+        setModulation(targetModulationRateHz, targetModulationDepthMs);
+        setDelayTime(targetDelayMs);
+
+        reset();
+    }
+
+    void reset()
+    {
+        lines.clear();
+        writeIndex = 0;
+
+        for (auto& channel : channels)
+        {
+            channel.input = channel.wet = SampleType(0);
+            channel.lowCutState = channel.highCutState = channel.thiranState = SampleType(0);
+        }
+
+        lfoSin = SampleType(0);
+        lfoCos = SampleType(1);
+
+        currentDelaySamples = targetDelaySamples;
+        currentModulationSamples = targetModulationSamples;
+        currentFeedback = targetFeedback;
+        currentMix = targetMix;
+    }
+
+    /*
+        carries on from where other is: the write position, LFO phase, glides, filter states
+        and the part of the lines the read position can reach.
+        both have to be prepared with the same spec, so the copy doesn't allocate.
+        the lines hold up to 8 s, so only the live window behind the write position is copied:
+        the longer of the current and target delay, plus the modulation depth and the interpolation taps.
+        anything older keeps whatever this delay last held there.
+    */
+    void copyStateFrom(const ModulatedDelay& other)
+    {
+        jassert(lines.getNumChannels() == other.lines.getNumChannels() && lines.getNumSamples() == other.lines.getNumSamples());
+
+        const auto longestDelaySamples = juce::jmax(other.currentDelaySamples, other.targetDelaySamples)
+                                       + juce::jmax(other.currentModulationSamples, other.targetModulationSamples);
+        const auto window = juce::jmin(other.mask + 1, static_cast<int>(std::ceil(longestDelaySamples)) + 4);
+
+        //the window ends right behind the write position, and wraps round the start of the line when it reaches past it.
+        const auto start = (other.writeIndex - window) & other.mask;
+        const auto firstPart = juce::jmin(window, other.mask + 1 - start);
+
+        for (int ch = 0; ch < lines.getNumChannels(); ++ch)
+        {
+            lines.copyFrom(ch, start, other.lines, ch, start, firstPart);
+
+            if (firstPart < window)
+                lines.copyFrom(ch, 0, other.lines, ch, 0, window - firstPart);
+        }
+
+        //same size, so this reuses the storage
+        channels = other.channels;
+        writeIndex = other.writeIndex;
+        interpolation = other.interpolation;
+        pingPong = other.pingPong;
+
+        targetDelayMs = other.targetDelayMs;
+        targetDelaySamples = other.targetDelaySamples;
+        currentDelaySamples = other.currentDelaySamples;
+        glideCoefficient = other.glideCoefficient;
+
+        targetFeedback = other.targetFeedback;
+        currentFeedback = other.currentFeedback;
+        targetMix = other.targetMix;
+        currentMix = other.currentMix;
+
+        targetLowCutHz = other.targetLowCutHz;
+        lowCutHz = other.lowCutHz;
+        lowCutCoefficient = other.lowCutCoefficient;
+        targetHighCutHz = other.targetHighCutHz;
+        highCutHz = other.highCutHz;
+        highCutCoefficient = other.highCutCoefficient;
+
+        targetModulationRateHz = other.targetModulationRateHz;
+        modulationRateHz = other.modulationRateHz;
+        targetModulationDepthMs = other.targetModulationDepthMs;
+        targetModulationSamples = other.targetModulationSamples;
+        currentModulationSamples = other.currentModulationSamples;
+        lfoSin = other.lfoSin;
+        lfoCos = other.lfoCos;
+        lfoRotationSin = other.lfoRotationSin;
+        lfoRotationCos = other.lfoRotationCos;
+    }
+
+    void setDelayTime(SampleType newDelayMs) noexcept
+    {
+        targetDelayMs = juce::jlimit(minDelayMs, maxDelayMs, newDelayMs);
+        targetDelaySamples = static_cast<SampleType>(targetDelayMs * 0.001 * sampleRate);
+    }
+
+    // 0 to 1. the feedback filters keep anything below 1 from building up.
+    void setFeedback(SampleType newFeedback) noexcept
+    {
+        jassert(std::abs(newFeedback) < SampleType(1));
+        targetFeedback = newFeedback;
+    }
+
+    void setFeedbackFilter(SampleType newLowCutHz, SampleType newHighCutHz) noexcept
+    {
+        targetLowCutHz = newLowCutHz;
+        targetHighCutHz = newHighCutHz;
+
+        if (newLowCutHz == lowCutHz && newHighCutHz == highCutHz)
+            return;
+
+        lowCutHz = newLowCutHz;
+        highCutHz = newHighCutHz;
+        lowCutCoefficient = getOnePoleCoefficient(lowCutHz);
+        highCutCoefficient = getOnePoleCoefficient(highCutHz);
+    }
+
+    void setModulation(SampleType newRateHz, SampleType newDepthMs) noexcept
+    {
+        targetModulationRateHz = newRateHz;
+        targetModulationDepthMs = juce::jlimit(SampleType(0), maxModulationDepthMs, newDepthMs);
+        targetModulationSamples = static_cast<SampleType>(targetModulationDepthMs * 0.001 * sampleRate);
+
+        if (newRateHz == modulationRateHz)
+            return;
+
+        modulationRateHz = newRateHz;
+        const auto phaseIncrement = juce::MathConstants<double>::twoPi * modulationRateHz / sampleRate;
+        lfoRotationSin = static_cast<SampleType>(std::sin(phaseIncrement));
+        lfoRotationCos = static_cast<SampleType>(std::cos(phaseIncrement));
+    }
+
+    void setMix(SampleType newMix) noexcept
+    {
+        targetMix = newMix;
+    }
+
+    void setPingPong(bool shouldPingPong) noexcept
+    {
+        if (shouldPingPong == pingPong)
+            return;
+
+        pingPong = shouldPingPong;
+        updateRouting();
+    }
+
+    void setInterpolation(DelayInterpolation newInterpolation) noexcept
+    {
+        interpolation = newInterpolation;
+    }
+
+    //the longest the delay can be with these settings, modulation included.
+    double getLongestDelaySeconds() const noexcept
+    {
+        return (targetDelayMs + targetModulationDepthMs) * 0.001;
+    }
+
+    void process(const juce::dsp::ProcessContextReplacing<SampleType>& context)
+    {
+        if (context.isBypassed)
+            return;
+
+        auto& block = context.getOutputBlock();
+        jassert(block.getNumChannels() <= channels.size());
+
+        if (interpolation == DelayInterpolation::Thiran)
+            processSamples<DelayInterpolation::Thiran>(block);
+        else
+            processSamples<DelayInterpolation::Lagrange3rd>(block);
+    }
+
+private:
+    /*
+        the routing of one channel. ping-pong only changes these numbers, not the per-sample work.
+        a channel without a partner (the last one of an odd count) always feeds itself.
+    */
+    struct Channel
+    {
+        size_t partner = 0;
+        size_t feedbackSource = 0;
+        SampleType ownInputGain = SampleType(1);
+        SampleType partnerInputGain = SampleType(0);
+
+        SampleType input = SampleType(0), wet = SampleType(0);
+        SampleType lowCutState = SampleType(0), highCutState = SampleType(0);
+        SampleType thiranState = SampleType(0);
+    };
+
+    void updateRouting() noexcept
+    {
+        for (size_t ch = 0; ch < channels.size(); ++ch)
+        {
+            auto& channel = channels[ch];
+            channel.partner = (ch ^ 1) < channels.size() ? (ch ^ 1) : ch;
+
+            const auto bounces = pingPong && channel.partner != ch;
+            const auto isFirstOfPair = (ch & 1) == 0;
+
+            channel.feedbackSource = bounces ? channel.partner : ch;
+            channel.ownInputGain = ! bounces || isFirstOfPair ? SampleType(1) : SampleType(0);
+            channel.partnerInputGain = bounces && isFirstOfPair ? SampleType(1) : SampleType(0);
+        }
+    }
+
+    SampleType getOnePoleCoefficient(SampleType cutoffHz) const noexcept
+    {
+        const auto nyquist = sampleRate * 0.5;
+        const auto hz = juce::jlimit(1.0, nyquist * 0.99, static_cast<double>(cutoffHz));
+        return static_cast<SampleType>(1.0 - std::exp(-juce::MathConstants<double>::twoPi * hz / sampleRate));
+    }
+
+    //delay is at least 2 samples, so every tap is one that has been written already.
+    SampleType readLagrange3rd(const SampleType* line, SampleType delay) const noexcept
+    {
+        //the taps sit at delayInt - 1 .. delayInt + 2, and t is the read position measured from the first one.
+        const auto delayInt = static_cast<int>(delay);
+        const auto t = delay - static_cast<SampleType>(delayInt) + SampleType(1);
+        const auto first = writeIndex - delayInt + 1;
+
+        const auto v1 = line[first & mask];
+        const auto v2 = line[(first - 1) & mask];
+        const auto v3 = line[(first - 2) & mask];
+        const auto v4 = line[(first - 3) & mask];
+
+        const auto d1 = t - SampleType(1);
+        const auto d2 = t - SampleType(2);
+        const auto d3 = t - SampleType(3);
+
+        const auto c1 = -d1 * d2 * d3 * SampleType(1.0 / 6.0);
+        const auto c2 = d2 * d3 * SampleType(0.5);
+        const auto c3 = -d1 * d3 * SampleType(0.5);
+        const auto c4 = d1 * d2 * SampleType(1.0 / 6.0);
+
+        return v1 * c1 + t * (v2 * c2 + v3 * c3 + v4 * c4);
+    }
+
+    /*
+        the allpass is most accurate with a fractional delay between 0.618 and 1.618,
+        so the integer part is moved down one sample when the fraction is smaller.
+    */
+    SampleType readThiran(const SampleType* line, SampleType delay, SampleType& state) const noexcept
+    {
+        auto delayInt = static_cast<int>(delay);
+        auto frac = delay - static_cast<SampleType>(delayInt);
+
+        const auto shift = frac < SampleType(0.618) ? 1 : 0;
+        delayInt -= shift;
+        frac += static_cast<SampleType>(shift);
+
+        const auto alpha = (SampleType(1) - frac) / (SampleType(1) + frac);
+
+        const auto newer = line[(writeIndex - delayInt) & mask];
+        const auto older = line[(writeIndex - delayInt - 1) & mask];
+
+        state = older + alpha * (newer - state);
+        return state;
+    }
+
+    /*
+        the same work for every sample: glide, LFO, one read and one write per channel.
+        feedback, mix and modulation depth are ramped linearly across the block.
+    */
+    template<DelayInterpolation Interpolation>
+    void processSamples(juce::dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        const auto numSamples = block.getNumSamples();
+        const auto numChannels = block.getNumChannels();
+        if (numSamples == 0)
+            return;
+
+        const auto scale = SampleType(1) / static_cast<SampleType>(numSamples);
+        const auto feedbackStep = (targetFeedback - currentFeedback) * scale;
+        const auto mixStep = (targetMix - currentMix) * scale;
+        const auto modulationStep = (targetModulationSamples - currentModulationSamples) * scale;
+
+        const auto minDelaySamples = SampleType(2);
+        const auto maxDelaySamples = static_cast<SampleType>(mask - 3);
+        auto* const* lineData = lines.getArrayOfWritePointers();
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            currentDelaySamples += (targetDelaySamples - currentDelaySamples) * glideCoefficient;
+
+            const auto nextSin = lfoSin * lfoRotationCos + lfoCos * lfoRotationSin;
+            lfoCos = lfoCos * lfoRotationCos - lfoSin * lfoRotationSin;
+            lfoSin = nextSin;
+
+            //the modulation only ever lengthens the delay, so it can't push the read position past the write position.
+            const auto delay = juce::jlimit(minDelaySamples, maxDelaySamples,
+                                            currentDelaySamples + currentModulationSamples * SampleType(0.5) * (SampleType(1) + lfoSin));
+
+            for (size_t ch = 0; ch < numChannels; ++ch)
+            {
+                auto& channel = channels[ch];
+                channel.input = block.getChannelPointer(ch)[i];
+
+                if constexpr (Interpolation == DelayInterpolation::Thiran)
+                    channel.wet = readThiran(lineData[ch], delay, channel.thiranState);
+                else
+                    channel.wet = readLagrange3rd(lineData[ch], delay);
+            }
+
+            for (size_t ch = 0; ch < numChannels; ++ch)
+            {
+                auto& channel = channels[ch];
+
+                //high cut, then low cut. the low cut is the input minus a one-pole low-pass of it.
+                channel.highCutState += (channels[channel.feedbackSource].wet - channel.highCutState) * highCutCoefficient;
+                channel.lowCutState += (channel.highCutState - channel.lowCutState) * lowCutCoefficient;
+                const auto feedback = channel.highCutState - channel.lowCutState;
+
+                const auto input = channel.input * channel.ownInputGain + channels[channel.partner].input * channel.partnerInputGain;
+                lineData[ch][writeIndex] = input + feedback * currentFeedback;
+
+                block.getChannelPointer(ch)[i] = channel.input + (channel.wet - channel.input) * currentMix;
+            }
+
+            writeIndex = (writeIndex + 1) & mask;
+            currentFeedback += feedbackStep;
+            currentMix += mixStep;
+            currentModulationSamples += modulationStep;
+        }
+
+        currentFeedback = targetFeedback;
+        currentMix = targetMix;
+        currentModulationSamples = targetModulationSamples;
+
+        //the rotation drifts off the unit circle a little every sample. pulling it back once per block is enough.
+        const auto magnitude = std::sqrt(lfoSin * lfoSin + lfoCos * lfoCos);
+        lfoSin /= magnitude;
+        lfoCos /= magnitude;
+    }
+
+    juce::AudioBuffer<SampleType> lines;
+    std::vector<Channel> channels;
+    int writeIndex = 0, mask = 0;
+    double sampleRate = 44100.0;
+
+    DelayInterpolation interpolation = DelayInterpolation::Lagrange3rd;
+    bool pingPong = false;
+
+    SampleType targetDelayMs = SampleType(250);
+    SampleType targetDelaySamples = SampleType(0), currentDelaySamples = SampleType(0);
+    SampleType glideCoefficient = SampleType(1);
+
+    SampleType targetFeedback = SampleType(0), currentFeedback = SampleType(0);
+    SampleType targetMix = SampleType(0), currentMix = SampleType(0);
+
+    SampleType targetLowCutHz = SampleType(20), lowCutHz = SampleType(-1), lowCutCoefficient = SampleType(0);
+    SampleType targetHighCutHz = SampleType(20000), highCutHz = SampleType(-1), highCutCoefficient = SampleType(1);
+
+    SampleType targetModulationRateHz = SampleType(0), modulationRateHz = SampleType(-1);
+    SampleType targetModulationDepthMs = SampleType(0);
+    SampleType targetModulationSamples = SampleType(0), currentModulationSamples = SampleType(0);
+    SampleType lfoSin = SampleType(0), lfoCos = SampleType(1);
+    SampleType lfoRotationSin = SampleType(0), lfoRotationCos = SampleType(1);
+};
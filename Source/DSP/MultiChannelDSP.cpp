@@ -0,0 +1,412 @@
+/*
+  ==============================================================================
+
+    MultiChannelDSP.cpp
+
+  ==============================================================================
+*/
+
+#include "MultiChannelDSP.h"
+
+namespace
+{
+    //number of echoes until a feedback loop has dropped by 60dB
+    double getNumRepeatsUntilSilent(float feedback)
+    {
+        auto gain = juce::jmin(std::abs(static_cast<double>(feedback)), 0.999);
+        return gain < 0.001 ? 0.0 : std::log(0.001) / std::log(gain);
+    }
+
+    /*
+        6 first order allpass stages, swept around the centre frequency.
+        the lowest stage frequency rings the longest, and the feedback loop recirculates it.
+    */
+    double getPhaserTailLengthSeconds(const DSPParameters& params)
+    {
+        auto lowestFrequency = juce::jmax(20.0, params.phaserCenterFreqHz * 0.5);
+        auto stageRingSeconds = 6.9 / (juce::MathConstants<double>::twoPi * lowestFrequency);
+
+        return 6.0 * stageRingSeconds * (1.0 + getNumRepeatsUntilSilent(params.phaserFeedbackPercent * 0.01f));
+    }
+
+    //juce::dsp::Chorus modulates the delay by up to 20ms at full depth.
+    double getChorusTailLengthSeconds(const DSPParameters& params)
+    {
+        auto longestDelaySeconds = (params.chorusCenterDelayMs + 20.0 * params.chorusDepthPercent * 0.01) * 0.001;
+
+        return longestDelaySeconds * (1.0 + getNumRepeatsUntilSilent(params.chorusFeedbackPercent * 0.01f));
+    }
+
+    //the feedback filters only shorten it, so this is the unfiltered decay.
+    template<typename SampleType>
+    double getDelayTailLengthSeconds(const ModulatedDelay<SampleType>& delay, const DSPParameters& params)
+    {
+        return delay.getLongestDelaySeconds() * (1.0 + getNumRepeatsUntilSilent(params.delayFeedbackPercent * 0.01f));
+    }
+}
+
+template<typename SampleType>
+const std::array<typename MultiChannelDSP<SampleType>::Kernel, MultiChannelDSP<SampleType>::NumKernels> MultiChannelDSP<SampleType>::kernels = MultiChannelDSP<SampleType>::makeKernels(std::make_index_sequence<NumKernels>());
+
+template<typename SampleType>
+void MultiChannelDSP<SampleType>::prepare(const juce::dsp::ProcessSpec& spec, const DSP_Bypassed& bypassed)
+{
+    preparedSpec = spec;
+
+    /*
+        a stage that was prepared before keeps its old buffers when it is skipped now.
+        it is only marked unprepared, and prepareSkippedStages() prepares it again for this spec.
+    */
+    forEachStage([&spec, &bypassed, this](auto& stage, size_t index)
+    {
+        const auto shouldPrepare = ! bypassed[index];
+        if (shouldPrepare)
+        {
+            stage.prepare(spec);
+            stage.reset();
+        }
+
+        stageReady[index] = shouldPrepare;
+        stagePrepared[index].store(shouldPrepare, std::memory_order_release);
+    });
+
+    //the chain starts with every stage fully on or fully off, there's nothing to fade from.
+    bypassCrossfader.prepare(spec);
+    for (size_t index = 0; index < numStages; ++index)
+        bypassCrossfader.setBypassed(index, bypassed[index]);
+
+    bypassCrossfader.reset();
+
+    //sized for the longest latency, so switching the oversampling never allocates
+    overdriveCompensation.prepare(spec, Overdrive<SampleType>::getMaxLatencyInSamples());
+
+    //force the general filter coefficients to be rebuilt for the new sample rate.
+    filterMode = GeneralFilterMode::END_OF_LIST;
+}
+
+template<typename SampleType>
+bool MultiChannelDSP<SampleType>::prepareSkippedStages(const DSP_Bypassed& bypassed)
+{
+    if (preparedSpec.sampleRate <= 0.0)
+        return false;
+
+    bool preparedAny = false;
+    forEachStage([&bypassed, &preparedAny, this](auto& stage, size_t index)
+    {
+        //acquire: a stage the audio thread has handed back is no longer touched there
+        if (bypassed[index] || stagePrepared[index].load(std::memory_order_acquire))
+            return;
+
+        stage.prepare(preparedSpec);
+        stage.reset();
+
+        //release: the audio thread sees the prepared stage before it sees the flag
+        stagePrepared[index].store(true, std::memory_order_release);
+        preparedAny = true;
+    });
+
+    return preparedAny;
+}
+
+template<typename SampleType>
+bool MultiChannelDSP<SampleType>::takePreparedStage(size_t index) noexcept
+{
+    if (stageReady[index] || ! stagePrepared[index].load(std::memory_order_acquire))
+        return false;
+
+    stageReady[index] = true;
+
+    if (index == static_cast<size_t>(DSP_Option::GeneralFilter))
+        filterMode = GeneralFilterMode::END_OF_LIST;
+
+    return true;
+}
+
+template<typename SampleType>
+void MultiChannelDSP<SampleType>::reset()
+{
+    forEachStage([this](auto& stage, size_t index)
+    {
+        if (stageReady[index])
+            stage.reset();
+    });
+
+    bypassCrossfader.reset();
+    overdriveCompensation.reset();
+}
+
+template<typename SampleType>
+void MultiChannelDSP<SampleType>::copyStateFrom(const MultiChannelDSP& other)
+{
+    jassert(preparedSpec.sampleRate == other.preparedSpec.sampleRate
+            && preparedSpec.maximumBlockSize == other.preparedSpec.maximumBlockSize
+            && preparedSpec.numChannels == other.preparedSpec.numChannels);
+
+    /*
+        a stage only one of the chains has prepared can't be copied.
+        one that isn't running in other, because it isn't ready there or is fully bypassed, isn't copied either:
+        it takes over other's full bypass instead, and starts from a clean state when it comes back.
+    */
+    forEachStageWith(other, [this, &other](auto& stage, const auto& otherStage, size_t index)
+    {
+        takePreparedStage(index);
+        if (! stageReady[index])
+            return;
+
+        //updateDSPFromParams() keeps a stage that isn't ready fully bypassed
+        jassert(other.stageReady[index] || other.bypassCrossfader.isFullyBypassed(index));
+
+        if (! other.bypassCrossfader.isFullyBypassed(index))
+            stage.copyStateFrom(otherStage);
+
+        bypassCrossfader.copyStageFrom(other.bypassCrossfader, index);
+    });
+
+    overdriveCompensation.copyStateFrom(other.overdriveCompensation);
+
+    //the copied general filter runs other's coefficients now
+    if (stageReady[static_cast<size_t>(DSP_Option::GeneralFilter)] && ! other.bypassCrossfader.isFullyBypassed(static_cast<size_t>(DSP_Option::GeneralFilter)))
+    {
+        filterMode = other.filterMode;
+        filterFreq = other.filterFreq;
+        filterQ = other.filterQ;
+        filterGain = other.filterGain;
+    }
+}
+
+template<typename SampleType>
+void MultiChannelDSP<SampleType>::updateDSPFromParams(const DSPParameters& params)
+{
+    /*
+        a stage that was fully bypassed restarts from a clean state before it fades back in.
+        a stage that isn't ready yet counts as bypassed, so it fades in once the message thread has prepared it.
+    */
+    forEachStage([this, &params](auto& stage, size_t index)
+    {
+        //one that has only just been prepared is clean already
+        const auto freshlyPrepared = takePreparedStage(index);
+        if (! bypassCrossfader.setBypassed(index, params.bypassed[index] || ! stageReady[index]) || freshlyPrepared)
+            return;
+
+        if (! defersStageResets)
+        {
+            stage.reset();
+            return;
+        }
+
+        //resetting the delay clears MBs. the message thread does that, and the stage stays bypassed until it's ready again.
+        stageReady[index] = false;
+        stagePrepared[index].store(false, std::memory_order_release);
+        bypassCrossfader.setBypassed(index, true);
+    });
+
+    if (isStageReady(DSP_Option::Phaser))
+    {
+        phaser.dsp.setRate( params.phaserRateHz );
+        phaser.dsp.setCentreFrequency( params.phaserCenterFreqHz );
+        phaser.dsp.setDepth( params.phaserDepthPercent * 0.01f);
+        phaser.dsp.setFeedback( params.phaserFeedbackPercent * 0.01f);
+        phaser.dsp.setMix( params.phaserMixPercent * 0.01f);
+    }
+
+    if (isStageReady(DSP_Option::Chorus))
+    {
+        chorus.dsp.setRate( params.chorusRateHz );
+        chorus.dsp.setDepth( params.chorusDepthPercent * 0.01f);
+        chorus.dsp.setCentreDelay( params.chorusCenterDelayMs );
+        chorus.dsp.setFeedback( params.chorusFeedbackPercent * 0.01f);
+        chorus.dsp.setMix( params.chorusMixPercent * 0.01f);
+    }
+
+    overdriveCompensation.setDelay(getLatencyInSamples(params));
+
+    if (isStageReady(DSP_Option::OverDrive))
+    {
+        overdrive.dsp.setDrive( params.overdriveSaturation );
+        overdrive.dsp.setOversampling( params.overdriveOversampling, params.overdriveFilterType );
+    }
+
+    if (isStageReady(DSP_Option::LadderFilter))
+    {
+        ladderFilter.dsp.forEachGroup([&](auto& filter)
+        {
+            filter.setMode( params.ladderFilterMode );
+            filter.setCutoffFrequencyHz( params.ladderFilterCutoffHz );
+            filter.setResonance( params.ladderFilterResonancePercent * 0.01f);
+            filter.setDrive( params.ladderFilterDrive );
+        });
+    }
+
+    //update generalFilter coefficients
+    //choices: peak, bandpass, notch, allpass
+    auto genHz = params.generalFilterFreqHz;
+    auto genQ = params.generalFilterQuality;
+    auto genGain = params.generalFilterGainDb;
+
+    bool filterChanged = false;
+    filterChanged |= (filterFreq != genHz);
+    filterChanged |= (filterQ != genQ);
+    filterChanged |= (filterGain != genGain);
+
+    auto updatedMode = params.generalFilterMode;
+    filterChanged |= (filterMode != updatedMode);
+
+    //the cached values stay as they are until the filter is ready, which rebuilds the coefficients anyway.
+    if (filterChanged && isStageReady(DSP_Option::GeneralFilter))
+    {
+        filterMode = updatedMode;
+        filterFreq = genHz;
+        filterQ = genQ;
+        filterGain = genGain;
+
+        /*
+            the filter glides to the new coefficients and keeps its state,
+            so this is safe to call while the filter is running.
+        */
+        generalFilter.dsp.forEachGroup([&](auto& filter)
+        {
+            filter.setParameters(filterMode, filterFreq, filterQ, filterGain);
+        });
+    }
+
+    if (isStageReady(DSP_Option::Delay))
+    {
+        delay.dsp.setDelayTime( params.delayTimeMs );
+        delay.dsp.setFeedback( params.delayFeedbackPercent * 0.01f );
+        delay.dsp.setFeedbackFilter( params.delayLowCutHz, params.delayHighCutHz );
+        delay.dsp.setModulation( params.delayModulationRateHz, params.delayModulationDepthMs );
+        delay.dsp.setMix( params.delayMixPercent * 0.01f );
+        delay.dsp.setPingPong( params.delayPingPong );
+        delay.dsp.setInterpolation( params.delayInterpolation );
+    }
+}
+
+template<typename SampleType>
+int MultiChannelDSP<SampleType>::getLatencyInSamples(const DSPParameters& params) const
+{
+    return Overdrive<SampleType>::getLatencyInSamples(params.overdriveOversampling, params.overdriveFilterType);
+}
+
+template<typename SampleType>
+double MultiChannelDSP<SampleType>::getTailLengthSeconds(const DSPParameters& params) const
+{
+    auto isActive = [this, &params](DSP_Option option) { return ! params.bypassed[static_cast<size_t>(option)] && isStageReady(option); };
+
+    double tail = 0.0;
+
+    if (isActive(DSP_Option::Phaser))
+        tail += getPhaserTailLengthSeconds(params);
+
+    if (isActive(DSP_Option::Chorus))
+        tail += getChorusTailLengthSeconds(params);
+
+    //the overdrive's oversampling filters, or the compensation delay that stands in for them while it's bypassed
+    if (preparedSpec.sampleRate > 0.0)
+        tail += getLatencyInSamples(params) / preparedSpec.sampleRate;
+
+    double longestGroupTail = 0.0;
+    auto findLongestTail = [&longestGroupTail](const auto& filter)
+    {
+        longestGroupTail = juce::jmax(longestGroupTail, static_cast<double>(filter.getTailLengthSeconds()));
+    };
+
+    if (isActive(DSP_Option::LadderFilter))
+    {
+        ladderFilter.dsp.forEachGroup(findLongestTail);
+        tail += longestGroupTail;
+    }
+
+    if (isActive(DSP_Option::GeneralFilter))
+    {
+        longestGroupTail = 0.0;
+        generalFilter.dsp.forEachGroup(findLongestTail);
+        tail += longestGroupTail;
+    }
+
+    if (isActive(DSP_Option::Delay))
+        tail += getDelayTailLengthSeconds(delay.dsp, params);
+
+    return juce::jmin(tail, maxTailLengthSeconds);
+}
+
+template<typename SampleType>
+void MultiChannelDSP<SampleType>::process(juce::dsp::AudioBlock<SampleType> block, const DSP_Order &dspOrder, const DSPParameters& params)
+{
+    if (kernel == nullptr || dspOrder != kernelOrder)
+    {
+        kernelOrder = dspOrder;
+        kernel = nullptr;
+
+        if (getIndexFromDSPOrder(dspOrder) < NumDSPOrders)
+        {
+            //take the delay out, and look the kernel up by the order of the others
+            std::array<DSP_Option, numKernelStages> kernelStages{};
+            size_t next = 0;
+            for (size_t position = 0; position < numStages; ++position)
+            {
+                if (dspOrder[position] == DSP_Option::Delay)
+                    kernelDelayPosition = position;
+                else
+                    kernelStages[next++] = dspOrder[position];
+            }
+
+            kernel = kernels[getIndexFromDSPOrder(kernelStages)];
+        }
+    }
+
+    if (kernel == nullptr)
+    {
+        processWithRuntimeOrder(block, dspOrder, params);
+        return;
+    }
+
+    auto context = Context(block);
+    kernel(*this, context, params, kernelDelayPosition);
+}
+
+template<typename SampleType>
+void MultiChannelDSP<SampleType>::processWithRuntimeOrder(juce::dsp::AudioBlock<SampleType> block, const DSP_Order &dspOrder, const DSPParameters& params)
+{
+    auto context = Context(block);
+
+    for (auto option : dspOrder)
+    {
+#if VERIFY_BYPASS_FUNCTIONALITY
+        if (params.bypassed[static_cast<size_t>(option)])
+        {
+            jassertfalse;
+        }
+
+        if (option == DSP_Option::GeneralFilter)
+        {
+            continue;
+        }
+#endif
+        switch (option) {
+        case DSP_Option::Phaser:
+            processStage<DSP_Option::Phaser>(context, params);
+            break;
+        case DSP_Option::Chorus:
+            processStage<DSP_Option::Chorus>(context, params);
+            break;
+        case DSP_Option::OverDrive:
+            processStage<DSP_Option::OverDrive>(context, params);
+            break;
+        case DSP_Option::LadderFilter:
+            processStage<DSP_Option::LadderFilter>(context, params);
+            break;
+        case DSP_Option::GeneralFilter:
+            processStage<DSP_Option::GeneralFilter>(context, params);
+            break;
+        case DSP_Option::Delay:
+            processStage<DSP_Option::Delay>(context, params);
+            break;
+        case DSP_Option::END_OF_LIST:
+            jassertfalse;
+            break;
+        }
+    }
+}
+
+template struct MultiChannelDSP<float>;
+template struct MultiChannelDSP<double>;
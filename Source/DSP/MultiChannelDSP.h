@@ -0,0 +1,419 @@
+/*
+  ==============================================================================
+
+    MultiChannelDSP.h
+
+    The reorderable effect chain.
+    One instance processes every channel in lock-step: the phaser and chorus
+    share their modulation across channels, the ladder filter and the
+    general filter run on SIMD lanes (see SIMDChannelPacker), the overdrive
+    shapes every channel at the oversampled rate, and the delay reads every
+    channel at the same modulated position.
+    Bypassed stages are skipped entirely, and toggling a bypass crossfades
+    the stage in or out (see BypassCrossfader).
+    Only the stages that are switched on when the chain is prepared get their
+    buffers. A stage switched on later is prepared on the message thread by
+    prepareSkippedStages(), and stays bypassed until that has happened. Realtime,
+    a stage coming back from a full bypass goes the same way to be reset.
+    The chain is a template on the sample type: MultiChannelDSP<float> and
+    MultiChannelDSP<double> share every line of code, and the SIMD groups
+    are as wide as the register is for that type.
+    Nothing the audio thread calls allocates once prepare() has been called.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "LadderFilter.h"
+#include "GeneralFilter.h"
+#include "Overdrive.h"
+#include "ModulatedDelay.h"
+#include "SIMDChannelPacker.h"
+#include "BypassCrossfader.h"
+#include "CompensationDelay.h"
+#include "../Diagnostics/StageProfiler.h"
+
+# define VERIFY_BYPASS_FUNCTIONALITY false
+
+//strongly typed enumeration (scoped enumeration)
+enum class DSP_Option
+{
+    Phaser,
+    Chorus,
+    OverDrive,
+    LadderFilter,
+    GeneralFilter,
+    Delay,
+    END_OF_LIST
+};
+
+static_assert(static_cast<int>(ProfiledSection::Delay) == static_cast<int>(DSP_Option::Delay),
+              "the chain stages come first in ProfiledSection, in DSP_Option order");
+
+//array alias
+using DSP_Order = std::array < DSP_Option, static_cast<size_t>(DSP_Option::END_OF_LIST)>;
+
+//one flag per stage, indexed by DSP_Option
+using DSP_Bypassed = std::array<bool, static_cast<size_t>(DSP_Option::END_OF_LIST)>;
+
+/*
+    every valid DSP_Order is a permutation of the DSP_Options.
+    permutations are numbered in lexicographic order, which lets the chain pre-generate its kernels.
+    both helpers also work on the first numOptions options alone, e.g. every stage but the delay.
+*/
+static constexpr size_t factorial(size_t n) { return n <= 1 ? 1 : n * factorial(n - 1); }
+
+static constexpr size_t NumDSPOrders = factorial(static_cast<size_t>(DSP_Option::END_OF_LIST));
+
+template<size_t numOptions = static_cast<size_t>(DSP_Option::END_OF_LIST)>
+static constexpr std::array<DSP_Option, numOptions> getDSPOrderFromIndex(size_t index)
+{
+    std::array<DSP_Option, numOptions> remaining{};
+    for (size_t i = 0; i < numOptions; ++i)
+        remaining[i] = static_cast<DSP_Option>(i);
+
+    std::array<DSP_Option, numOptions> order{};
+    for (size_t i = 0; i < numOptions; ++i)
+    {
+        auto numRemaining = numOptions - i;
+        auto f = factorial(numRemaining - 1);
+        auto pick = index / f;
+        index %= f;
+
+        order[i] = remaining[pick];
+        for (size_t j = pick; j + 1 < numRemaining; ++j)
+            remaining[j] = remaining[j + 1];
+    }
+
+    return order;
+}
+
+// returns factorial(numOptions) (NumDSPOrders for a DSP_Order) if the order isn't a permutation, i.e. it has duplicates or END_OF_LIST in it.
+template<size_t numOptions>
+static constexpr size_t getIndexFromDSPOrder(const std::array<DSP_Option, numOptions>& order)
+{
+    std::array<bool, numOptions> used{};
+    size_t index = 0;
+    for (size_t i = 0; i < numOptions; ++i)
+    {
+        auto option = static_cast<size_t>(order[i]);
+        if (option >= numOptions || used[option])
+            return factorial(numOptions);
+
+        size_t rank = 0;
+        for (size_t j = 0; j < option; ++j)
+            rank += used[j] ? 0 : 1;
+
+        index += rank * factorial(numOptions - 1 - i);
+        used[option] = true;
+    }
+
+    return index;
+}
+
+/*
+    plain copies of the (smoothed) parameter values the chain needs.
+    filled once per sub-block by the processor.
+*/
+struct DSPParameters
+{
+    float phaserRateHz = 0.f;
+    float phaserCenterFreqHz = 0.f;
+    float phaserDepthPercent = 0.f;
+    float phaserFeedbackPercent = 0.f;
+    float phaserMixPercent = 0.f;
+
+    float chorusRateHz = 0.f;
+    float chorusDepthPercent = 0.f;
+    float chorusCenterDelayMs = 0.f;
+    float chorusFeedbackPercent = 0.f;
+    float chorusMixPercent = 0.f;
+
+    float overdriveSaturation = 1.f;
+    OverdriveOversampling overdriveOversampling = OverdriveOversampling::x2;
+    OverdriveFilterType overdriveFilterType = OverdriveFilterType::PolyphaseIIR;
+
+    juce::dsp::LadderFilterMode ladderFilterMode = juce::dsp::LadderFilterMode::LPF12;
+    float ladderFilterCutoffHz = 20000.f;
+    float ladderFilterResonancePercent = 0.f;
+    float ladderFilterDrive = 1.f;
+
+    GeneralFilterMode generalFilterMode = GeneralFilterMode::Peak;
+    float generalFilterFreqHz = 750.f;
+    float generalFilterQuality = 0.72f;
+    float generalFilterGainDb = 0.f;
+
+    //already converted from the host tempo when the delay is synced
+    float delayTimeMs = 250.f;
+    float delayFeedbackPercent = 0.f;
+    float delayLowCutHz = 20.f;
+    float delayHighCutHz = 20000.f;
+    float delayModulationRateHz = 0.f;
+    float delayModulationDepthMs = 0.f;
+    float delayMixPercent = 0.f;
+    bool delayPingPong = false;
+    DelayInterpolation delayInterpolation = DelayInterpolation::Lagrange3rd;
+
+    DSP_Bypassed bypassed{};
+};
+
+template<typename DSP> // class template, we can create versions for different DSP effect types
+struct DSP_Choice
+{
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        dsp.prepare(spec);
+    }
+    template<typename ProcessContext>
+    void process(const ProcessContext& context)
+    {
+        dsp.process(context);
+    }
+    void reset()
+    {
+        dsp.reset();
+    }
+    /*
+        takes over the running state of the same stage in another chain.
+        juce::dsp::Phaser and Chorus keep theirs private and can't be copied, so they start from a clean state.
+    */
+    void copyStateFrom(const DSP_Choice& other)
+    {
+        if constexpr (requires { dsp.copyStateFrom(other.dsp); })
+            dsp.copyStateFrom(other.dsp);
+        else
+            dsp.reset();
+    }
+
+    DSP dsp;
+};
+
+template<typename SampleType>
+struct MultiChannelDSP
+{
+    using Lanes = juce::dsp::SIMDRegister<SampleType>;
+    using PackedLadderFilter = SIMDChannelPacker<LadderFilter<Lanes>, SampleType>;
+    using PackedGeneralFilter = SIMDChannelPacker<GeneralFilter<Lanes>, SampleType>;
+
+    DSP_Choice<juce::dsp::Phaser<SampleType>> phaser;
+    DSP_Choice<juce::dsp::Chorus<SampleType>> chorus;
+    DSP_Choice<Overdrive<SampleType>> overdrive;
+    DSP_Choice<PackedLadderFilter> ladderFilter;
+    DSP_Choice<PackedGeneralFilter> generalFilter;
+    DSP_Choice<ModulatedDelay<SampleType>> delay;
+
+    // prepares the stages that aren't bypassed. the others are left unprepared, without any buffers.
+    void prepare(const juce::dsp::ProcessSpec& spec, const DSP_Bypassed& bypassed);
+
+    /*
+        prepares the stages prepare() skipped that bypassed now switches on, and resets the ones handed back
+        by setDefersStageResets(). returns true if there were any.
+        call it on the message thread, while the audio thread keeps running:
+        the audio thread doesn't touch a stage before it is prepared, and fades it in once it is.
+    */
+    bool prepareSkippedStages(const DSP_Bypassed& bypassed);
+
+    // clears every stage and snaps any gliding coefficients to their targets.
+    void reset();
+
+    /*
+        takes over other's running state (delay lines, LFO phases, filter memories and bypass fades),
+        so this chain carries on from where the sound is instead of from silence.
+        both chains have to be prepared with the same spec, so nothing is allocated.
+    */
+    void copyStateFrom(const MultiChannelDSP& other);
+
+    void updateDSPFromParams(const DSPParameters& params);
+
+    /*
+        with this on, a stage coming back from a full bypass isn't reset on the audio thread.
+        it is handed back to prepareSkippedStages() instead, and stays bypassed until it's ready again.
+        off by default, for a chain without a message thread calling prepareSkippedStages().
+    */
+    void setDefersStageResets(bool shouldDefer) noexcept { defersStageResets = shouldDefer; }
+
+    // every stage that runs is timed into this profiler. nullptr turns the timing off.
+    void setProfiler(StageProfiler* newProfiler) noexcept { profiler = newProfiler; }
+
+    /*
+        the delay the chain adds with these settings. only the oversampled overdrive adds any,
+        and the chain delays its dry path by the same amount, so it's the same whether the overdrive is bypassed or not.
+    */
+    int getLatencyInSamples(const DSPParameters& params) const;
+
+    /*
+        how long the chain keeps ringing after the input goes silent: the sum of every active stage's tail.
+        capped at maxTailLengthSeconds, a self-oscillating filter would never end.
+    */
+    double getTailLengthSeconds(const DSPParameters& params) const;
+    static constexpr double maxTailLengthSeconds = 30.0;
+
+    /*
+        jumps straight into the kernel that was generated for dspOrder.
+        orders that aren't permutations fall back to processWithRuntimeOrder().
+        kernels are only generated for the order of the stages before the delay was added (120 per sample type, not 720),
+        and the delay's position is passed to the kernel: one predictable branch per stage instead of 6x the code.
+    */
+    void process(juce::dsp::AudioBlock<SampleType> block, const DSP_Order& dspOrder, const DSPParameters& params);
+
+    // walks dspOrder at runtime and switches on every stage.
+    void processWithRuntimeOrder(juce::dsp::AudioBlock<SampleType> block, const DSP_Order& dspOrder, const DSPParameters& params);
+
+private:
+    GeneralFilterMode filterMode = GeneralFilterMode::END_OF_LIST;
+    float filterFreq = 0.f, filterQ = 0.f, filterGain = -100.f;
+
+    using Context = juce::dsp::ProcessContextReplacing<SampleType>;
+    using Kernel = void (*)(MultiChannelDSP&, const Context&, const DSPParameters&, size_t delayPosition);
+
+    static constexpr size_t numStages = static_cast<size_t>(DSP_Option::END_OF_LIST);
+
+    //the delay is the last option, so the kernels are keyed on the order of options 0 .. numKernelStages - 1.
+    static_assert(static_cast<size_t>(DSP_Option::Delay) == numStages - 1, "the delay has to be the last DSP_Option");
+    static constexpr size_t numKernelStages = numStages - 1;
+    static constexpr size_t NumKernels = factorial(numKernelStages);
+
+    //fn(stage, index), in DSP_Option order
+    template<typename Fn>
+    void forEachStage(Fn&& fn)
+    {
+        fn(phaser, static_cast<size_t>(DSP_Option::Phaser));
+        fn(chorus, static_cast<size_t>(DSP_Option::Chorus));
+        fn(overdrive, static_cast<size_t>(DSP_Option::OverDrive));
+        fn(ladderFilter, static_cast<size_t>(DSP_Option::LadderFilter));
+        fn(generalFilter, static_cast<size_t>(DSP_Option::GeneralFilter));
+        fn(delay, static_cast<size_t>(DSP_Option::Delay));
+    }
+
+    //fn(stage, otherStage, index), in DSP_Option order
+    template<typename Fn>
+    void forEachStageWith(const MultiChannelDSP& other, Fn&& fn)
+    {
+        fn(phaser, other.phaser, static_cast<size_t>(DSP_Option::Phaser));
+        fn(chorus, other.chorus, static_cast<size_t>(DSP_Option::Chorus));
+        fn(overdrive, other.overdrive, static_cast<size_t>(DSP_Option::OverDrive));
+        fn(ladderFilter, other.ladderFilter, static_cast<size_t>(DSP_Option::LadderFilter));
+        fn(generalFilter, other.generalFilter, static_cast<size_t>(DSP_Option::GeneralFilter));
+        fn(delay, other.delay, static_cast<size_t>(DSP_Option::Delay));
+    }
+
+    //the audio thread's side of stagePrepared
+    bool isStageReady(DSP_Option option) const noexcept { return stageReady[static_cast<size_t>(option)]; }
+
+    //marks a stage the message thread has prepared as ready. true if it has only just become ready.
+    bool takePreparedStage(size_t index) noexcept;
+
+    template<DSP_Option option>
+    auto& getStage()
+    {
+        if constexpr (option == DSP_Option::Phaser)
+            return phaser;
+        else if constexpr (option == DSP_Option::Chorus)
+            return chorus;
+        else if constexpr (option == DSP_Option::OverDrive)
+            return overdrive;
+        else if constexpr (option == DSP_Option::LadderFilter)
+            return ladderFilter;
+        else if constexpr (option == DSP_Option::GeneralFilter)
+            return generalFilter;
+        else if constexpr (option == DSP_Option::Delay)
+            return delay;
+    }
+
+    //the bypass state comes from bypassCrossfader, which updateDSPFromParams() keeps in sync with params.
+    template<DSP_Option option>
+    void processStage(const Context& context, const DSPParameters& params)
+    {
+        juce::ignoreUnused(params);
+        constexpr auto index = static_cast<size_t>(option);
+
+        //the overdrive's latency is there whether it runs or not, the signal around it is delayed to match.
+        constexpr auto compensated = option == DSP_Option::OverDrive;
+        auto& block = context.getOutputBlock();
+
+        if (bypassCrossfader.isFullyBypassed(index))
+        {
+            if constexpr (compensated)
+                overdriveCompensation.process(block);
+
+            return;
+        }
+
+        auto& stage = getStage<option>();
+        StageProfiler::ScopedTimer timer(profiler, static_cast<ProfiledSection>(index));
+
+        if (! bypassCrossfader.isFading(index))
+        {
+            if constexpr (compensated)
+                overdriveCompensation.push(block);
+
+            stage.process(context);
+            return;
+        }
+
+        bypassCrossfader.storeDry(block);
+
+        if constexpr (compensated)
+            overdriveCompensation.process(bypassCrossfader.getDry(block.getNumChannels(), block.getNumSamples()));
+
+        stage.process(context);
+        bypassCrossfader.mixWithDry(index, block);
+    }
+
+    BypassCrossfader<SampleType, static_cast<size_t>(DSP_Option::END_OF_LIST)> bypassCrossfader;
+    CompensationDelay<SampleType> overdriveCompensation;
+    StageProfiler* profiler = nullptr;
+    bool defersStageResets = false;
+
+    /*
+        stagePrepared is set by the thread that prepared a stage.
+        the audio thread copies it into stageReady in updateDSPFromParams(), and only uses a stage once it is ready there.
+        it clears both when it hands a stage back to be reset.
+    */
+    std::array<std::atomic<bool>, numStages> stagePrepared{};
+    std::array<bool, numStages> stageReady{};
+    juce::dsp::ProcessSpec preparedSpec{};
+
+    //the delay goes in front of the stage at delayPosition, or after the last one.
+    template<DSP_Option option, size_t Position>
+    void processStageAfterDelay(const Context& context, const DSPParameters& params, size_t delayPosition)
+    {
+        if (delayPosition == Position)
+            processStage<DSP_Option::Delay>(context, params);
+
+        processStage<option>(context, params);
+    }
+
+    template<size_t OrderIndex, size_t... Stage>
+    static void processStages(MultiChannelDSP& chain, const Context& context, const DSPParameters& params, size_t delayPosition, std::index_sequence<Stage...>)
+    {
+        constexpr auto order = getDSPOrderFromIndex<numKernelStages>(OrderIndex);
+        (chain.template processStageAfterDelay<order[Stage], Stage>(context, params, delayPosition), ...);
+
+        if (delayPosition == numKernelStages)
+            chain.template processStage<DSP_Option::Delay>(context, params);
+    }
+
+    // one fully inlined kernel per order of the stages other than the delay.
+    template<size_t OrderIndex>
+    static void processInOrder(MultiChannelDSP& chain, const Context& context, const DSPParameters& params, size_t delayPosition)
+    {
+        processStages<OrderIndex>(chain, context, params, delayPosition, std::make_index_sequence<numKernelStages>());
+    }
+
+    template<size_t... OrderIndex>
+    static std::array<Kernel, sizeof...(OrderIndex)> makeKernels(std::index_sequence<OrderIndex...>)
+    {
+        return { &processInOrder<OrderIndex>... };
+    }
+
+    //indexed by getIndexFromDSPOrder() of the order without the delay
+    static const std::array<Kernel, NumKernels> kernels;
+
+    //the kernel lookup only happens when the order changes.
+    DSP_Order kernelOrder{};
+    Kernel kernel = nullptr;
+    size_t kernelDelayPosition = 0;
+};
@@ -0,0 +1,241 @@
+/*
+  ==============================================================================
+
+    Overdrive.h
+
+    Waveshaping overdrive: drive -> softClip() -> makeup gain, run at 1x, 2x,
+    4x or 8x the host rate through juce::dsp::Oversampling.
+    Every oversampler is built in prepare(), so changing the factor or the
+    filter type while playing only swaps a pointer.
+    The latency of the selected oversampler is exposed so the processor can
+    report it to the host. It is known for every factor and filter type
+    before the overdrive is prepared, so the chain can report it and keep
+    its dry path in time while the overdrive is bypassed.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "VectorKernels.h"
+
+enum class OverdriveOversampling
+{
+    x1,
+    x2,
+    x4,
+    x8,
+    END_OF_LIST
+};
+
+enum class OverdriveFilterType
+{
+    PolyphaseIIR,
+    FIR,
+    END_OF_LIST
+};
+
+template<typename SampleType>
+struct Overdrive
+{
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+        getLatencyTable();
+
+        for (size_t filterIndex = 0; filterIndex < numFilterTypes; ++filterIndex)
+        {
+            //1x doesn't need an oversampler
+            oversamplers[filterIndex][0].reset();
+
+            for (size_t factorIndex = 1; factorIndex < numFactors; ++factorIndex)
+            {
+                auto& oversampler = oversamplers[filterIndex][factorIndex];
+                oversampler = std::make_unique<Oversampler>(spec.numChannels,
+                                                            factorIndex,
+                                                            getJuceFilterType(static_cast<OverdriveFilterType>(filterIndex)),
+                                                            true,
+                                                            true); //integer latency, so it can be reported to the host exactly
+                oversampler->initProcessing(spec.maximumBlockSize);
+            }
+        }
+
+        selectOversampler();
+        reset();
+    }
+
+    void reset()
+    {
+        for (auto& perFilterType : oversamplers)
+            for (auto& oversampler : perFilterType)
+                if (oversampler != nullptr)
+                    oversampler->reset();
+
+        currentDrive = targetDrive;
+        currentMakeup = targetMakeup;
+    }
+
+    /*
+        carries on with other's drive ramp and oversampling choice.
+        the oversampling filters can't be copied, so they start from silence.
+    */
+    void copyStateFrom(const Overdrive& other) noexcept
+    {
+        targetDrive = other.targetDrive;
+        currentDrive = other.currentDrive;
+        targetMakeup = other.targetMakeup;
+        currentMakeup = other.currentMakeup;
+
+        factor = other.factor;
+        filterType = other.filterType;
+        selectOversampler();
+
+        if (activeOversampler != nullptr)
+            activeOversampler->reset();
+    }
+
+    void setDrive(SampleType newDrive) noexcept
+    {
+        jassert(newDrive >= SampleType(1));
+
+        if (newDrive == targetDrive)
+            return;
+
+        //same makeup curve as juce::dsp::LadderFilter, so the level matches the old overdrive
+        targetDrive = newDrive;
+        targetMakeup = std::pow(targetDrive, SampleType(-2.642)) * SampleType(0.6103) + SampleType(0.3903);
+    }
+
+    // switching clears the incoming oversampler, it is only called when the parameters change.
+    void setOversampling(OverdriveOversampling newFactor, OverdriveFilterType newFilterType) noexcept
+    {
+        if (newFactor == factor && newFilterType == filterType)
+            return;
+
+        factor = newFactor;
+        filterType = newFilterType;
+        selectOversampler();
+
+        if (activeOversampler != nullptr)
+            activeOversampler->reset();
+    }
+
+    int getLatencyInSamples() const noexcept
+    {
+        return getLatencyInSamples(factor, filterType);
+    }
+
+    /*
+        the latency of the oversampler for this factor and filter type, prepared or not.
+        it only depends on the filter design, so every oversampler is built once to measure it.
+        that happens the first time this is called, which has to be on the message thread (prepare() does it).
+    */
+    static int getLatencyInSamples(OverdriveOversampling oversampling, OverdriveFilterType type) noexcept
+    {
+        return getLatencyTable()[static_cast<size_t>(type)][static_cast<size_t>(oversampling)];
+    }
+
+    static int getMaxLatencyInSamples() noexcept
+    {
+        int maxLatency = 0;
+        for (const auto& perFilterType : getLatencyTable())
+            for (auto latency : perFilterType)
+                maxLatency = juce::jmax(maxLatency, latency);
+
+        return maxLatency;
+    }
+
+    //the shaper itself is memoryless, only the oversampling filters ring.
+    double getTailLengthSeconds() const noexcept
+    {
+        return getLatencyInSamples() / sampleRate;
+    }
+
+    void process(const juce::dsp::ProcessContextReplacing<SampleType>& context)
+    {
+        if (context.isBypassed)
+            return;
+
+        auto& block = context.getOutputBlock();
+
+        if (activeOversampler == nullptr)
+        {
+            shape(block);
+            return;
+        }
+
+        auto oversampledBlock = activeOversampler->processSamplesUp(block);
+        shape(oversampledBlock);
+        activeOversampler->processSamplesDown(block);
+    }
+
+private:
+    using Oversampler = juce::dsp::Oversampling<SampleType>;
+
+    static constexpr auto numFactors = static_cast<size_t>(OverdriveOversampling::END_OF_LIST);
+    static constexpr auto numFilterTypes = static_cast<size_t>(OverdriveFilterType::END_OF_LIST);
+    using LatencyTable = std::array<std::array<int, numFactors>, numFilterTypes>;
+
+    static const LatencyTable& getLatencyTable()
+    {
+        static const LatencyTable table = []
+        {
+            LatencyTable latencies{};
+            for (size_t filterIndex = 0; filterIndex < numFilterTypes; ++filterIndex)
+                for (size_t factorIndex = 1; factorIndex < numFactors; ++factorIndex)
+                {
+                    const Oversampler oversampler(1, factorIndex, getJuceFilterType(static_cast<OverdriveFilterType>(filterIndex)), true, true);
+                    latencies[filterIndex][factorIndex] = juce::roundToInt(oversampler.getLatencyInSamples());
+                }
+
+            return latencies;
+        }();
+
+        return table;
+    }
+
+    static typename Oversampler::FilterType getJuceFilterType(OverdriveFilterType type)
+    {
+        return type == OverdriveFilterType::FIR ? Oversampler::filterHalfBandFIREquiripple
+                                                : Oversampler::filterHalfBandPolyphaseIIR;
+    }
+
+    void selectOversampler()
+    {
+        activeOversampler = oversamplers[static_cast<size_t>(filterType)][static_cast<size_t>(factor)].get();
+    }
+
+    /*
+        drive and makeup are ramped linearly across the block.
+        the loop itself is VectorKernels::shape, built for the widest instruction set the CPU has.
+    */
+    void shape(juce::dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        const auto numSamples = block.getNumSamples();
+        if (numSamples == 0)
+            return;
+
+        const auto scale = SampleType(1) / static_cast<SampleType>(numSamples);
+        const auto driveStep = (targetDrive - currentDrive) * scale;
+        const auto makeupStep = (targetMakeup - currentMakeup) * scale;
+
+        for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+            kernels.shape(block.getChannelPointer(ch), numSamples, currentDrive, driveStep, currentMakeup, makeupStep);
+
+        currentDrive = targetDrive;
+        currentMakeup = targetMakeup;
+    }
+
+    std::array<std::array<std::unique_ptr<Oversampler>, static_cast<size_t>(OverdriveOversampling::END_OF_LIST)>,
+               static_cast<size_t>(OverdriveFilterType::END_OF_LIST)> oversamplers;
+    Oversampler* activeOversampler = nullptr;
+    const VectorKernels<SampleType>& kernels = VectorKernels<SampleType>::get();
+    double sampleRate = 44100.0;
+
+    OverdriveOversampling factor = OverdriveOversampling::x2;
+    OverdriveFilterType filterType = OverdriveFilterType::PolyphaseIIR;
+
+    SampleType targetDrive = SampleType(1), currentDrive = SampleType(1);
+    SampleType targetMakeup = SampleType(1), currentMakeup = SampleType(1);
+};
@@ -0,0 +1,165 @@
+/*
+  ==============================================================================
+
+    ParallelChain.cpp
+
+  ==============================================================================
+*/
+
+#include "ParallelChain.h"
+
+template<typename SampleType>
+size_t ParallelChain<SampleType>::getChannelsPerGroup(size_t numChannels, int maxNumGroups, bool keepChannelPairs) noexcept
+{
+    const auto numGroups = static_cast<size_t>(juce::jlimit(1, static_cast<int>(numChannels), maxNumGroups));
+    constexpr auto laneCount = juce::dsp::SIMDRegister<SampleType>::SIMDNumElements;
+
+    //groups wider than a register are rounded up to whole registers, so no lanes are wasted.
+    auto channelsPerGroup = (numChannels + numGroups - 1) / numGroups;
+    if (channelsPerGroup > laneCount)
+        channelsPerGroup = (channelsPerGroup + laneCount - 1) / laneCount * laneCount;
+
+    //a ping-pong pair never straddles two groups.
+    if (keepChannelPairs)
+        channelsPerGroup += channelsPerGroup % 2;
+
+    return channelsPerGroup;
+}
+
+template<typename SampleType>
+bool ParallelChain<SampleType>::isGroupedFor(bool keepChannelPairs) const noexcept
+{
+    if (groups.empty())
+        return true;
+
+    return getChannelsPerGroup(numPreparedChannels, preparedMaxNumGroups, keepChannelPairs) == channelsPerPreparedGroup;
+}
+
+template<typename SampleType>
+void ParallelChain<SampleType>::prepare(const juce::dsp::ProcessSpec& spec, int maxNumGroups, const DSP_Bypassed& bypassed, bool keepChannelPairs)
+{
+    const auto numChannels = static_cast<size_t>(juce::jmax(1u, spec.numChannels));
+    const auto channelsPerGroup = getChannelsPerGroup(numChannels, maxNumGroups, keepChannelPairs);
+
+    numPreparedChannels = numChannels;
+    channelsPerPreparedGroup = channelsPerGroup;
+    preparedMaxNumGroups = maxNumGroups;
+
+    groups.clear();
+    for (size_t first = 0; first < numChannels; first += channelsPerGroup)
+    {
+        auto& group = *groups.emplace_back(std::make_unique<Group>());
+        group.firstChannel = first;
+        group.numChannels = juce::jmin(channelsPerGroup, numChannels - first);
+
+        auto groupSpec = spec;
+        groupSpec.numChannels = static_cast<juce::uint32>(group.numChannels);
+        group.chain.prepare(groupSpec, bypassed);
+        group.chain.setProfiler(profiler);
+        group.chain.setDefersStageResets(defersStageResets);
+    }
+}
+
+template<typename SampleType>
+bool ParallelChain<SampleType>::prepareSkippedStages(const DSP_Bypassed& bypassed)
+{
+    bool preparedAny = false;
+    for (auto& group : groups)
+        preparedAny |= group->chain.prepareSkippedStages(bypassed);
+
+    return preparedAny;
+}
+
+template<typename SampleType>
+void ParallelChain<SampleType>::reset()
+{
+    for (auto& group : groups)
+        group->chain.reset();
+}
+
+template<typename SampleType>
+void ParallelChain<SampleType>::setFadeLengthSeconds(double newFadeLengthSeconds) noexcept
+{
+    for (auto& group : groups)
+        group->chain.setFadeLengthSeconds(newFadeLengthSeconds);
+}
+
+template<typename SampleType>
+void ParallelChain<SampleType>::setProfiler(StageProfiler* newProfiler) noexcept
+{
+    profiler = newProfiler;
+
+    for (auto& group : groups)
+        group->chain.setProfiler(profiler);
+}
+
+template<typename SampleType>
+void ParallelChain<SampleType>::setDefersStageResets(bool shouldDefer) noexcept
+{
+    defersStageResets = shouldDefer;
+
+    for (auto& group : groups)
+        group->chain.setDefersStageResets(defersStageResets);
+}
+
+template<typename SampleType>
+void ParallelChain<SampleType>::updateDSPFromParams(const DSPParameters& params)
+{
+    for (auto& group : groups)
+        group->chain.updateDSPFromParams(params);
+}
+
+template<typename SampleType>
+int ParallelChain<SampleType>::getLatencyInSamples(const DSPParameters& params) const
+{
+    //every group runs the same stages
+    return groups.empty() ? 0 : groups.front()->chain.getLatencyInSamples(params);
+}
+
+template<typename SampleType>
+double ParallelChain<SampleType>::getTailLengthSeconds(const DSPParameters& params) const
+{
+    return groups.empty() ? 0.0 : groups.front()->chain.getTailLengthSeconds(params);
+}
+
+template<typename SampleType>
+void ParallelChain<SampleType>::process(juce::dsp::AudioBlock<SampleType> block, const DSP_Order& dspOrder, const DSPParameters& params, RealtimeWorkerPool* pool)
+{
+    currentBlock = block;
+    currentOrder = &dspOrder;
+    currentParams = &params;
+
+    const auto numGroups = getNumGroups();
+    const auto runInParallel = pool != nullptr
+                            && pool->getNumWorkers() > 0
+                            && numGroups > 1
+                            && block.getNumSamples() >= minSamplesForParallel;
+
+    if (runInParallel)
+    {
+        pool->run(numGroups, &ParallelChain::processGroup, this);
+    }
+    else
+    {
+        for (int i = 0; i < numGroups; ++i)
+            processGroup(this, i);
+    }
+}
+
+template<typename SampleType>
+void ParallelChain<SampleType>::processGroup(void* context, int groupIndex)
+{
+    auto& self = *static_cast<ParallelChain*>(context);
+    auto& group = *self.groups[static_cast<size_t>(groupIndex)];
+
+    //a host can hand over fewer channels than were prepared
+    const auto numChannels = self.currentBlock.getNumChannels();
+    if (group.firstChannel >= numChannels)
+        return;
+
+    auto groupBlock = self.currentBlock.getSubsetChannelBlock(group.firstChannel, juce::jmin(group.numChannels, numChannels - group.firstChannel));
+    group.chain.process(groupBlock, *self.currentOrder, *self.currentParams);
+}
+
+template struct ParallelChain<float>;
+template struct ParallelChain<double>;
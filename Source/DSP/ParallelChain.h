@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    ParallelChain.h
+
+    Splits the channels into groups and gives every group its own
+    CrossfadingChain, so the groups can run on a RealtimeWorkerPool.
+    The groups see the same parameters and are prepared/reset together, so
+    their modulation stays in step, and the output is the same whether the
+    groups ran in parallel or one after the other.
+    Groups are a whole number of SIMD registers wide where the channel count
+    allows it. Only while the delay ping-pongs are they also a whole number
+    of channel pairs, because its pairs (0/1, 2/3, ...) feed each other
+    sample by sample and can't be split. Otherwise every channel can have a
+    group of its own, e.g. left and right on two threads.
+    With one group this is just a CrossfadingChain.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CrossfadingChain.h"
+#include "RealtimeWorkerPool.h"
+
+template<typename SampleType>
+struct ParallelChain
+{
+    /*
+        a group runs in less time than it takes to wake a worker below this many samples,
+        so smaller sub-blocks are processed serially on the calling thread.
+    */
+    static constexpr size_t minSamplesForParallel = 256;
+
+    /*
+        the channels are split into at most maxNumGroups groups, whole channel pairs if keepChannelPairs is set.
+        only the stages that aren't bypassed are prepared.
+    */
+    void prepare(const juce::dsp::ProcessSpec& spec, int maxNumGroups, const DSP_Bypassed& bypassed, bool keepChannelPairs);
+
+    // false if prepare() with this keepChannelPairs would group the channels differently than they are now.
+    bool isGroupedFor(bool keepChannelPairs) const noexcept;
+
+    // message thread. see MultiChannelDSP::prepareSkippedStages().
+    bool prepareSkippedStages(const DSP_Bypassed& bypassed);
+    void reset();
+
+    void setFadeLengthSeconds(double newFadeLengthSeconds) noexcept;
+    void updateDSPFromParams(const DSPParameters& params);
+
+    // kept across prepare(), every group times its stages into it.
+    void setProfiler(StageProfiler* newProfiler) noexcept;
+
+    // kept across prepare(). see MultiChannelDSP::setDefersStageResets().
+    void setDefersStageResets(bool shouldDefer) noexcept;
+
+    int getLatencyInSamples(const DSPParameters& params) const;
+    double getTailLengthSeconds(const DSPParameters& params) const;
+
+    int getNumGroups() const noexcept { return static_cast<int>(groups.size()); }
+
+    // with a pool and a large enough block, the groups are spread over its workers.
+    void process(juce::dsp::AudioBlock<SampleType> block, const DSP_Order& dspOrder, const DSPParameters& params, RealtimeWorkerPool* pool);
+
+private:
+    struct Group
+    {
+        size_t firstChannel = 0, numChannels = 0;
+        CrossfadingChain<SampleType> chain;
+    };
+
+    static void processGroup(void* context, int groupIndex);
+    static size_t getChannelsPerGroup(size_t numChannels, int maxNumGroups, bool keepChannelPairs) noexcept;
+
+    std::vector<std::unique_ptr<Group>> groups;
+    size_t numPreparedChannels = 0, channelsPerPreparedGroup = 0;
+    int preparedMaxNumGroups = 1;
+    StageProfiler* profiler = nullptr;
+    bool defersStageResets = false;
+
+    //what processGroup() works on. only valid during process().
+    juce::dsp::AudioBlock<SampleType> currentBlock;
+    const DSP_Order* currentOrder = nullptr;
+    const DSPParameters* currentParams = nullptr;
+};
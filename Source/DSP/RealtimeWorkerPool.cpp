@@ -0,0 +1,214 @@
+/*
+  ==============================================================================
+
+    RealtimeWorkerPool.cpp
+
+  ==============================================================================
+*/
+
+#include "RealtimeWorkerPool.h"
+#include "../Diagnostics/AllocationTracker.h"
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+namespace
+{
+    //tells the core this is a spin loop, so it doesn't starve its hyperthread sibling
+    inline void spinPause() noexcept
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #elif JUCE_ARM && (JUCE_CLANG || JUCE_GCC)
+        __asm__ __volatile__ ("yield");
+       #endif
+    }
+
+    /*
+        every logical core but the first, which is left to the host.
+        the mask only has 32 bits, so on bigger machines the workers stay on the first 32 cores.
+    */
+    juce::uint32 getWorkerAffinityMask()
+    {
+        const auto numCores = juce::jlimit(1, 32, juce::SystemStats::getNumCpus());
+        const auto allCores = numCores == 32 ? 0xffffffffu : (1u << numCores) - 1u;
+
+        return numCores > 1 ? allCores & ~1u : allCores;
+    }
+}
+
+struct RealtimeWorkerPool::Worker : juce::Thread
+{
+    Worker(RealtimeWorkerPool& owner, int index)
+        : juce::Thread("DSP Worker " + juce::String(index)),
+          pool(owner)
+    {
+    }
+
+    void run() override
+    {
+        juce::Thread::setCurrentThreadAffinityMask(getWorkerAffinityMask());
+
+        //the host thread's flush-to-zero mode isn't inherited. without it, a decaying tail runs on denormals here.
+        juce::ScopedNoDenormals noDenormals;
+
+        auto lastBatch = pool.batch.load(std::memory_order_acquire);
+
+        while (! threadShouldExit())
+        {
+            if (! waitForBatch(lastBatch))
+                continue;
+
+            lastBatch = pool.batch.load(std::memory_order_acquire);
+
+            AllocationTracker::ScopedRealtimeSection realtimeSection;
+            while (pool.runNextJob()) {}
+        }
+    }
+
+    // spins for spinTimeMs, then sleeps. true once a batch newer than lastBatch was published.
+    bool waitForBatch(juce::uint32 lastBatch)
+    {
+        const auto spinUntil = juce::Time::getMillisecondCounterHiRes() + spinTimeMs;
+
+        do
+        {
+            for (int i = 0; i < 64; ++i)
+            {
+                if (pool.batch.load(std::memory_order_acquire) != lastBatch)
+                    return true;
+
+                spinPause();
+            }
+        }
+        while (juce::Time::getMillisecondCounterHiRes() < spinUntil);
+
+        /*
+            run() bumps the batch before it looks at 'sleeping', and this thread sets 'sleeping' before it looks at the batch.
+            both are sequentially consistent, so at least one side sees the other and the wake-up can't be lost.
+            waiting on the counter itself means run() wakes this thread with a futex wake, it never takes a lock.
+        */
+        sleeping.store(true);
+        if (! threadShouldExit())
+            pool.batch.wait(lastBatch);
+        sleeping.store(false);
+
+        return pool.batch.load(std::memory_order_acquire) != lastBatch;
+    }
+
+    RealtimeWorkerPool& pool;
+
+    std::atomic<bool> sleeping{ false };
+};
+
+RealtimeWorkerPool::RealtimeWorkerPool() = default;
+
+RealtimeWorkerPool::~RealtimeWorkerPool()
+{
+    stop();
+}
+
+std::shared_ptr<RealtimeWorkerPool> RealtimeWorkerPool::getShared()
+{
+    //like the filter tables, the cache only holds a weak reference.
+    static juce::CriticalSection lock;
+    static std::weak_ptr<RealtimeWorkerPool> shared;
+
+    const juce::ScopedLock sl(lock);
+
+    if (auto existing = shared.lock())
+        return existing;
+
+    auto pool = std::make_shared<RealtimeWorkerPool>();
+    pool->start(getDefaultNumWorkers());
+    shared = pool;
+    return pool;
+}
+
+void RealtimeWorkerPool::start(int numWorkers)
+{
+    stop();
+
+    numWorkers = juce::jlimit(0, maxNumWorkers, numWorkers);
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto& worker = workers.emplace_back(std::make_unique<Worker>(*this, i));
+
+        if (! worker->startRealtimeThread(juce::Thread::RealtimeOptions{}))
+            worker->startThread(juce::Thread::Priority::highest);
+    }
+}
+
+void RealtimeWorkerPool::stop()
+{
+    for (auto& worker : workers)
+        worker->signalThreadShouldExit();
+
+    //an empty batch wakes the sleeping workers, they find no job in it and see they should exit.
+    batch.fetch_add(1);
+    batch.notify_all();
+
+    for (auto& worker : workers)
+        worker->stopThread(1000);
+
+    workers.clear();
+}
+
+int RealtimeWorkerPool::getDefaultNumWorkers()
+{
+    return juce::jlimit(0, maxNumWorkers, juce::SystemStats::getNumPhysicalCpus() - 1);
+}
+
+void RealtimeWorkerPool::run(int numJobs, Job job, void* context) noexcept
+{
+    if (numJobs <= 0)
+        return;
+
+    if (busy.exchange(true, std::memory_order_acquire))
+    {
+        for (int i = 0; i < numJobs; ++i)
+            job(context, i);
+
+        return;
+    }
+
+    currentJob = job;
+    currentContext = context;
+    jobsRemaining.store(numJobs, std::memory_order_relaxed);
+
+    //publishes the job along with the claim counter
+    claims.store(static_cast<juce::uint64>(numJobs) << 32, std::memory_order_release);
+    batch.fetch_add(1);
+
+    for (auto& worker : workers)
+    {
+        if (worker->sleeping.load())
+        {
+            batch.notify_all();
+            break;
+        }
+    }
+
+    while (runNextJob()) {}
+
+    while (jobsRemaining.load(std::memory_order_acquire) > 0)
+        spinPause();
+
+    claims.store(0, std::memory_order_relaxed);
+    busy.store(false, std::memory_order_release);
+}
+
+bool RealtimeWorkerPool::runNextJob() noexcept
+{
+    const auto claim = claims.fetch_add(1, std::memory_order_acq_rel);
+    const auto index = static_cast<int>(claim & 0xffffffffu);
+    const auto numJobs = static_cast<int>(claim >> 32);
+
+    if (index >= numJobs)
+        return false;
+
+    currentJob(currentContext, index);
+    jobsRemaining.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
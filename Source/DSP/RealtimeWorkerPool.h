@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    RealtimeWorkerPool.h
+
+    A few real-time threads that help the audio thread get through one batch
+    of independent jobs, e.g. one job per channel group of the chain.
+        - run() publishes the batch, then the audio thread works on it too,
+          so it is never just waiting on a worker that hasn't woken up yet.
+        - jobs are claimed with one atomic increment. nothing is locked and
+          nothing is allocated.
+        - idle workers spin for spinTimeMs before they go to sleep, so back to
+          back batches don't pay for a wake-up. sleeping workers wait on the
+          batch counter (std::atomic::wait), and are only woken if one of
+          them is actually asleep.
+    Plugin instances share one pool per process (getShared()), so a session
+    with many instances still only has getDefaultNumWorkers() workers. Only
+    one batch runs on the pool at a time: an instance that finds it busy
+    runs its jobs on its own thread instead of waiting.
+    Workers may run on any logical core but the first. They aren't pinned to
+    one core each, so they never get stuck behind another process' threads.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct RealtimeWorkerPool
+{
+    using Job = void (*)(void* context, int jobIndex);
+
+    static constexpr int maxNumWorkers = 7;
+    static constexpr double spinTimeMs = 0.5;
+
+    RealtimeWorkerPool();
+    ~RealtimeWorkerPool();
+
+    /*
+        the pool every instance in the process shares, started with getDefaultNumWorkers() workers.
+        it stops once the last instance lets go of it. message thread only.
+    */
+    static std::shared_ptr<RealtimeWorkerPool> getShared();
+
+    /*
+        stops the current workers and starts numWorkers new ones. 0 leaves the pool empty.
+        message thread only, never while run() is in progress.
+    */
+    void start(int numWorkers);
+    void stop();
+
+    int getNumWorkers() const noexcept { return static_cast<int>(workers.size()); }
+
+    // one less than the number of physical cores, so the host's audio thread keeps one to itself.
+    static int getDefaultNumWorkers();
+
+    /*
+        calls job(context, i) for every i in [0, numJobs) and returns once they have all finished.
+        the calling thread takes part. with no workers, or while another thread's batch is running,
+        every job runs on the calling thread.
+    */
+    void run(int numJobs, Job job, void* context) noexcept;
+
+private:
+    struct Worker;
+
+    // claims and runs one job of the current batch. false once there are none left.
+    bool runNextJob() noexcept;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    //bumped once per batch, workers compare it against the last batch they saw.
+    std::atomic<juce::uint32> batch{ 0 };
+
+    /*
+        number of jobs in the batch in the high 32 bits, next job index in the low 32 bits.
+        a claim reads both in one fetch_add, so a worker that turns up after the batch is over
+        (numJobs is 0 then) can never claim a job from the next one by mistake.
+    */
+    std::atomic<juce::uint64> claims{ 0 };
+    std::atomic<int> jobsRemaining{ 0 };
+
+    //set while a batch is running, so a second caller doesn't publish over it.
+    std::atomic<bool> busy{ false };
+
+    Job currentJob = nullptr;
+    void* currentContext = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE(RealtimeWorkerPool)
+};
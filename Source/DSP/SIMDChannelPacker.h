@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    SIMDChannelPacker.h
+
+    Runs a per-sample processor over several channels at once by packing the
+    channels into the lanes of a juce::dsp::SIMDRegister.
+    Channels are handled in groups of SIMDRegister::SIMDNumElements, and each
+    group owns one instance of the processor.
+
+    The processor only needs prepare(spec), reset() and
+    processSample(SIMDRegister), and has to be copy assignable for
+    copyStateFrom().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+template<typename Processor, typename NumericType = float>
+struct SIMDChannelPacker
+{
+    using Lanes = juce::dsp::SIMDRegister<NumericType>;
+    static constexpr size_t laneCount = Lanes::SIMDNumElements;
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        numChannels = spec.numChannels;
+        groups.resize((numChannels + laneCount - 1) / laneCount);
+
+        //every group processor sees a single (packed) channel.
+        auto groupSpec = spec;
+        groupSpec.numChannels = 1;
+        for (auto& group : groups)
+            group.prepare(groupSpec);
+
+        packed.resize(spec.maximumBlockSize);
+    }
+
+    void reset()
+    {
+        for (auto& group : groups)
+            group.reset();
+    }
+
+    // copies every group's processor. the other packer has to be prepared with the same spec.
+    void copyStateFrom(const SIMDChannelPacker& other)
+    {
+        jassert(groups.size() == other.groups.size());
+        std::copy_n(other.groups.begin(), juce::jmin(groups.size(), other.groups.size()), groups.begin());
+    }
+
+    void process(const juce::dsp::ProcessContextReplacing<NumericType>& context)
+    {
+        if (context.isBypassed)
+            return;
+
+        auto& block = context.getOutputBlock();
+        const auto numSamples = block.getNumSamples();
+        const auto channelsInBlock = juce::jmin(numChannels, block.getNumChannels());
+        jassert(numSamples <= packed.size());
+
+        for (size_t groupIndex = 0; groupIndex * laneCount < channelsInBlock; ++groupIndex)
+        {
+            const auto firstChannel = groupIndex * laneCount;
+            const auto numLanes = juce::jmin(laneCount, channelsInBlock - firstChannel);
+
+            //pack.  unused lanes are zero.
+            std::fill(packed.begin(), packed.begin() + static_cast<std::ptrdiff_t>(numSamples), Lanes::expand(NumericType(0)));
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                auto* channel = block.getChannelPointer(firstChannel + lane);
+                for (size_t i = 0; i < numSamples; ++i)
+                    packed[i].set(lane, channel[i]);
+            }
+
+            auto& processor = groups[groupIndex];
+            for (size_t i = 0; i < numSamples; ++i)
+                packed[i] = processor.processSample(packed[i]);
+
+            //unpack
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                auto* channel = block.getChannelPointer(firstChannel + lane);
+                for (size_t i = 0; i < numSamples; ++i)
+                    channel[i] = packed[i].get(lane);
+            }
+        }
+    }
+
+    template<typename Fn>
+    void forEachGroup(Fn&& fn)
+    {
+        for (auto& group : groups)
+            fn(group);
+    }
+
+    template<typename Fn>
+    void forEachGroup(Fn&& fn) const
+    {
+        for (const auto& group : groups)
+            fn(group);
+    }
+
+private:
+    size_t numChannels = 0;
+    std::vector<Processor> groups;
+    std::vector<Lanes> packed;
+};
@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    SilenceDetector.h
+
+    Decides when the chain can go to sleep.
+    The input has to stay silent for longer than the chain's tail before the
+    chain is skipped, and the first non-silent block wakes it up again.
+    It doesn't read the buffer itself: the input gain stage has already
+    measured the peak of what the chain is about to see.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "MeteredGain.h"
+
+struct SilenceDetector
+{
+    //-120 dBFS. anything quieter than this counts as silence.
+    static constexpr float silenceThreshold = 1.0e-6f;
+
+    void prepare(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        reset();
+    }
+
+    void reset()
+    {
+        silentSamples = 0;
+        asleep = false;
+    }
+
+    //true if everything the meter has seen since its last startMeasurement() is silent.
+    template<typename SampleType>
+    static bool isSilent(const MeteredGain<SampleType>& inputMeter, size_t numChannels)
+    {
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            if (inputMeter.getPeak(ch) > silenceThreshold)
+                return false;
+        }
+
+        return true;
+    }
+
+    /*
+        call once per sub-block, after the input gain has run on it and before the chain does.
+        returns true if the chain can be skipped for this sub-block.
+    */
+    bool update(bool inputIsSilent, int numSamples, double tailLengthSeconds) noexcept
+    {
+        if (! inputIsSilent)
+        {
+            silentSamples = 0;
+            asleep = false;
+            return false;
+        }
+
+        /*
+            the tail has to be over before this sub-block starts.
+            a tail that only ends part-way through it still gets processed.
+        */
+        asleep = static_cast<double>(silentSamples) >= tailLengthSeconds * sampleRate;
+        silentSamples += numSamples;
+        return asleep;
+    }
+
+    bool isAsleep() const noexcept { return asleep; }
+
+private:
+    double sampleRate = 44100.0;
+    juce::int64 silentSamples = 0;
+    bool asleep = false;
+};
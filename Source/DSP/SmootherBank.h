@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+
+    SmootherBank.h
+
+    A fixed-size bank of linear parameter smoothers stored as contiguous
+    arrays (structure-of-arrays) so every smoother can be retargeted and
+    advanced in a single pass without touching the heap.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+template<size_t NumSmoothers>
+struct SmootherBank
+{
+    /*
+        same behaviour as juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear>,
+        but with the state of every smoother laid out side by side.
+    */
+    void reset(double sampleRate, double rampLengthInSeconds)
+    {
+        jassert(sampleRate > 0 && rampLengthInSeconds >= 0);
+        stepsToTarget = static_cast<int>(std::floor(rampLengthInSeconds * sampleRate));
+
+        for (size_t i = 0; i < NumSmoothers; ++i)
+            setCurrentAndTargetValue(i, targets[i]);
+    }
+
+    void setCurrentAndTargetValue(size_t index, float newValue)
+    {
+        currents[index] = newValue;
+        targets[index] = newValue;
+        steps[index] = 0.f;
+        countdowns[index] = 0;
+    }
+
+    void setTargetValue(size_t index, float newValue)
+    {
+        if (newValue == targets[index])
+            return;
+
+        if (stepsToTarget <= 0)
+        {
+            setCurrentAndTargetValue(index, newValue);
+            return;
+        }
+
+        targets[index] = newValue;
+        countdowns[index] = stepsToTarget;
+        steps[index] = (newValue - currents[index]) / static_cast<float>(stepsToTarget);
+    }
+
+    void skip(size_t index, int numSamples)
+    {
+        if (numSamples >= countdowns[index])
+        {
+            currents[index] = targets[index];
+            countdowns[index] = 0;
+            return;
+        }
+
+        currents[index] += steps[index] * static_cast<float>(numSamples);
+        countdowns[index] -= numSamples;
+    }
+
+    void skipAll(int numSamples)
+    {
+        for (size_t i = 0; i < NumSmoothers; ++i)
+            skip(i, numSamples);
+    }
+
+    bool isAnySmoothing() const
+    {
+        for (auto countdown : countdowns)
+        {
+            if (countdown > 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    float getCurrentValue(size_t index) const { return currents[index]; }
+    float getTargetValue(size_t index) const { return targets[index]; }
+    bool isSmoothing(size_t index) const { return countdowns[index] > 0; }
+
+    static constexpr size_t size() { return NumSmoothers; }
+
+private:
+    std::array<float, NumSmoothers> currents{}, targets{}, steps{};
+    std::array<int, NumSmoothers> countdowns{};
+    int stepsToTarget = 0;
+};
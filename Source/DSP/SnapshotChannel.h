@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    SnapshotChannel.h
+
+    Triple-buffered hand-off of a plain struct from writer threads to the
+    audio thread.
+        - writers fill a private slot, then swap it into the shared 'middle'
+          slot. writers are serialised by a spin lock. the plugin publishes
+          from the audio thread itself, and from prepareToPlay while that
+          isn't running, so the lock is never contended there.
+        - the audio thread swaps the middle slot into its own slot when a new
+          one was published. when nothing changed that costs one atomic load.
+    Every slot sits on its own cache lines, so readers and writers never
+    share one.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+template<typename Snapshot>
+struct SnapshotChannel
+{
+    template<typename FillFn>
+    void publish(FillFn&& fill)
+    {
+        const juce::SpinLock::ScopedLockType lock(writerLock);
+
+        auto& slot = slots[static_cast<size_t>(writeIndex)];
+        fill(slot.value);
+        slot.version = ++latestVersion;
+
+        writeIndex = middle.exchange(writeIndex | freshBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // audio thread only.
+    const Snapshot& acquire() noexcept
+    {
+        if ((middle.load(std::memory_order_acquire) & freshBit) != 0)
+            readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+
+        return slots[static_cast<size_t>(readIndex)].value;
+    }
+
+    // the version of the snapshot the last acquire() returned. 0 until something was published.
+    juce::uint64 getAcquiredVersion() const noexcept
+    {
+        return slots[static_cast<size_t>(readIndex)].version;
+    }
+
+private:
+    static constexpr int freshBit = 4;
+    static constexpr int indexMask = 3;
+
+    struct alignas(64) Slot
+    {
+        Snapshot value{};
+        juce::uint64 version = 0;
+    };
+
+    std::array<Slot, 3> slots;
+
+    alignas(64) std::atomic<int> middle{ 2 };
+
+    alignas(64) int readIndex = 1;
+
+    alignas(64) juce::SpinLock writerLock;
+    int writeIndex = 0;
+    juce::uint64 latestVersion = 0;
+};
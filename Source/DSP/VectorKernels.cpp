@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    VectorKernels.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "VectorKernels.h"
+
+namespace VectorKernelsBaseline
+{
+   #include "VectorKernelsImpl.h"
+}
+
+#if JUCE_INTEL
+namespace VectorKernelsAVX2
+{
+    template<typename SampleType>
+    const VectorKernels<SampleType>& getKernels() noexcept;
+}
+
+namespace VectorKernelsAVX512
+{
+    template<typename SampleType>
+    const VectorKernels<SampleType>& getKernels() noexcept;
+}
+#endif
+
+namespace
+{
+    bool isSupported(InstructionSet set) noexcept
+    {
+        switch (set)
+        {
+        case InstructionSet::Baseline:
+            return true;
+       #if JUCE_INTEL
+        case InstructionSet::AVX2:
+            return juce::SystemStats::hasAVX2();
+        case InstructionSet::AVX512:
+            return juce::SystemStats::hasAVX512F();
+       #endif
+        default:
+            return false;
+        }
+    }
+}
+
+InstructionSet getBestInstructionSet() noexcept
+{
+    static const auto best = []
+    {
+        for (auto set = static_cast<int>(InstructionSet::END_OF_LIST) - 1; set > 0; --set)
+            if (isSupported(static_cast<InstructionSet>(set)))
+                return static_cast<InstructionSet>(set);
+
+        return InstructionSet::Baseline;
+    }();
+
+    return best;
+}
+
+const char* getInstructionSetName(InstructionSet set) noexcept
+{
+    switch (set)
+    {
+    case InstructionSet::Baseline:
+       #if JUCE_INTEL
+        return "SSE2";
+       #else
+        return "Baseline";
+       #endif
+    case InstructionSet::AVX2:
+        return "AVX2";
+    case InstructionSet::AVX512:
+        return "AVX512";
+    case InstructionSet::END_OF_LIST:
+        break;
+    }
+
+    jassertfalse;
+    return "";
+}
+
+template<typename SampleType>
+const VectorKernels<SampleType>& VectorKernels<SampleType>::get() noexcept
+{
+    static const auto& best = *get(getBestInstructionSet());
+    return best;
+}
+
+template<typename SampleType>
+const VectorKernels<SampleType>* VectorKernels<SampleType>::get(InstructionSet set) noexcept
+{
+    if (! isSupported(set))
+        return nullptr;
+
+    switch (set)
+    {
+    case InstructionSet::Baseline:
+        return &VectorKernelsBaseline::kernels<SampleType>;
+   #if JUCE_INTEL
+    case InstructionSet::AVX2:
+        return &VectorKernelsAVX2::getKernels<SampleType>();
+    case InstructionSet::AVX512:
+        return &VectorKernelsAVX512::getKernels<SampleType>();
+   #endif
+    default:
+        return nullptr;
+    }
+}
+
+template struct VectorKernels<float>;
+template struct VectorKernels<double>;
@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    VectorKernels.h
+
+    The plain per-sample loops the chain spends most of its time in,
+    compiled once per instruction set and picked at runtime:
+        Baseline    VectorKernels.cpp        (SSE2 on x86-64)
+        AVX2        VectorKernelsAVX2.cpp    (-mavx2, /arch:AVX2)
+        AVX512      VectorKernelsAVX512.cpp  (-mavx512f, /arch:AVX512)
+    The loop bodies live in VectorKernelsImpl.h and are identical for every
+    set, and none of them contracts into FMAs, so every set gives the same
+    output bit for bit.
+    This header is included by the AVX translation units, so it must not
+    pull in JuceHeader.h (see VectorKernelsImpl.h).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstddef>
+
+enum class InstructionSet
+{
+    Baseline,
+    AVX2,
+    AVX512,
+    END_OF_LIST
+};
+
+// the widest set this build has and this CPU runs. worked out once.
+InstructionSet getBestInstructionSet() noexcept;
+
+const char* getInstructionSetName(InstructionSet set) noexcept;
+
+template<typename SampleType>
+struct VectorKernels
+{
+    /*
+        samples[i] = softClip(samples[i] * drive) * makeup,
+        with drive and makeup ramped linearly: drive + driveStep * (i + 1)
+    */
+    void (*shape)(SampleType* samples, size_t numSamples,
+                  SampleType drive, SampleType driveStep,
+                  SampleType makeup, SampleType makeupStep) noexcept;
+
+    // wet[i] = wet[i] * wetGains[i] + dry[i] * dryGains[i]
+    void (*mix)(SampleType* wet, const SampleType* dry,
+                const SampleType* wetGains, const SampleType* dryGains, size_t numSamples) noexcept;
+
+    // the kernels for getBestInstructionSet().
+    static const VectorKernels& get() noexcept;
+
+    // nullptr if this build or this CPU doesn't have the set.
+    static const VectorKernels* get(InstructionSet set) noexcept;
+};
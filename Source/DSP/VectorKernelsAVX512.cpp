@@ -0,0 +1,27 @@
+/*
+  ==============================================================================
+
+    VectorKernelsAVX512.cpp
+
+    VectorKernelsImpl.h built for AVX512 (-mavx512f, /arch:AVX512).
+    The flags are set on this file alone, in CMakeLists.txt and in the
+    jucer's compiler flag schemes. Only reached once the CPU has been checked.
+
+  ==============================================================================
+*/
+
+#include "VectorKernels.h"
+
+namespace VectorKernelsAVX512
+{
+   #include "VectorKernelsImpl.h"
+
+    template<typename SampleType>
+    const VectorKernels<SampleType>& getKernels() noexcept
+    {
+        return kernels<SampleType>;
+    }
+
+    template const VectorKernels<float>& getKernels<float>() noexcept;
+    template const VectorKernels<double>& getKernels<double>() noexcept;
+}
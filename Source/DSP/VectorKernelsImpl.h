@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+
+    VectorKernelsImpl.h
+
+    The loops behind VectorKernels. Every VectorKernels*.cpp includes this
+    inside its own namespace, so there is no include guard.
+    Nothing in here calls a function, not even std::min: an inline function
+    that isn't inlined (e.g. in a debug build) is emitted by every
+    translation unit under the same name, and the linker could keep the
+    AVX-512 copy for the baseline path.
+
+  ==============================================================================
+*/
+
+namespace
+{
+    //softClip() from FastMath.h, written out
+    template<typename SampleType>
+    void shape(SampleType* samples, size_t numSamples,
+               SampleType drive, SampleType driveStep,
+               SampleType makeup, SampleType makeupStep) noexcept
+    {
+        constexpr auto limit = SampleType(1.5);
+        constexpr auto cubic = SampleType(4.0 / 27.0);
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            const auto n = static_cast<SampleType>(i + 1);
+            auto x = samples[i] * (drive + driveStep * n);
+
+            x = x < -limit ? -limit : (limit < x ? limit : x);
+            samples[i] = (x - x * x * x * cubic) * (makeup + makeupStep * n);
+        }
+    }
+
+    template<typename SampleType>
+    void mix(SampleType* wet, const SampleType* dry,
+             const SampleType* wetGains, const SampleType* dryGains, size_t numSamples) noexcept
+    {
+        for (size_t i = 0; i < numSamples; ++i)
+            wet[i] = wet[i] * wetGains[i] + dry[i] * dryGains[i];
+    }
+
+    //constant initialised, so no code from this file runs before the CPU has been checked
+    template<typename SampleType>
+    constexpr VectorKernels<SampleType> kernels { &shape<SampleType>, &mix<SampleType> };
+}
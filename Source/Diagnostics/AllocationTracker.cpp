@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    AllocationTracker.cpp
+
+  ==============================================================================
+*/
+
+#include "AllocationTracker.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local int realtimeDepth = 0;
+    thread_local int allowDepth = 0;
+    thread_local bool isReporting = false;
+
+    std::atomic<int> numRealtimeAllocations{ 0 };
+
+    void checkAllocation()
+    {
+        if (realtimeDepth == 0 || allowDepth > 0 || isReporting)
+            return;
+
+        numRealtimeAllocations.fetch_add(1, std::memory_order_relaxed);
+
+        /*
+            jassert logs the failure, and logging allocates.
+            the flag stops that allocation from being reported again.
+        */
+        isReporting = true;
+        jassertfalse; // operator new was called on the audio thread
+        isReporting = false;
+    }
+}
+
+AllocationTracker::ScopedRealtimeSection::ScopedRealtimeSection() { ++realtimeDepth; }
+AllocationTracker::ScopedRealtimeSection::~ScopedRealtimeSection() { --realtimeDepth; }
+
+AllocationTracker::ScopedAllowAllocation::ScopedAllowAllocation() { ++allowDepth; }
+AllocationTracker::ScopedAllowAllocation::~ScopedAllowAllocation() { --allowDepth; }
+
+bool AllocationTracker::isInRealtimeSection()
+{
+    return realtimeDepth > 0 && allowDepth == 0;
+}
+
+int AllocationTracker::getNumRealtimeAllocations()
+{
+    return numRealtimeAllocations.load(std::memory_order_relaxed);
+}
+
+#if TRACK_REALTIME_ALLOCATIONS
+/*
+    replacements for the global allocation functions.
+    they forward to malloc/free, so every form of new and delete has to be replaced together.
+*/
+static void* trackedAllocate(std::size_t size)
+{
+    checkAllocation();
+
+    if (auto* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+static void* trackedAllocateAligned(std::size_t size, std::align_val_t alignment)
+{
+    checkAllocation();
+
+    auto align = static_cast<std::size_t>(alignment);
+    size = (size + align - 1) & ~(align - 1);
+
+   #if JUCE_WINDOWS
+    if (auto* ptr = _aligned_malloc(size == 0 ? align : size, align))
+   #else
+    if (auto* ptr = std::aligned_alloc(align, size == 0 ? align : size))
+   #endif
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+static void trackedFreeAligned(void* ptr)
+{
+   #if JUCE_WINDOWS
+    _aligned_free(ptr);
+   #else
+    std::free(ptr);
+   #endif
+}
+
+void* operator new (std::size_t size) { return trackedAllocate(size); }
+void* operator new[] (std::size_t size) { return trackedAllocate(size); }
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept { checkAllocation(); return std::malloc(size == 0 ? 1 : size); }
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept { checkAllocation(); return std::malloc(size == 0 ? 1 : size); }
+void* operator new (std::size_t size, std::align_val_t alignment) { return trackedAllocateAligned(size, alignment); }
+void* operator new[] (std::size_t size, std::align_val_t alignment) { return trackedAllocateAligned(size, alignment); }
+
+void operator delete (void* ptr) noexcept { std::free(ptr); }
+void operator delete[] (void* ptr) noexcept { std::free(ptr); }
+void operator delete (void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[] (void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete (void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[] (void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete (void* ptr, std::align_val_t) noexcept { trackedFreeAligned(ptr); }
+void operator delete[] (void* ptr, std::align_val_t) noexcept { trackedFreeAligned(ptr); }
+void operator delete (void* ptr, std::size_t, std::align_val_t) noexcept { trackedFreeAligned(ptr); }
+void operator delete[] (void* ptr, std::size_t, std::align_val_t) noexcept { trackedFreeAligned(ptr); }
+#endif
@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+    AllocationTracker.h
+
+    Debug-build check that the audio thread never calls operator new.
+    The global allocation functions are replaced in AllocationTracker.cpp.
+    While a ScopedRealtimeSection is alive on a thread, any allocation made
+    on that thread hits a jassert.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef TRACK_REALTIME_ALLOCATIONS
+ #define TRACK_REALTIME_ALLOCATIONS JUCE_DEBUG
+#endif
+
+struct AllocationTracker
+{
+    /*
+        put one of these at the top of processBlock.
+        every operator new made by this thread before it goes out of scope is reported.
+    */
+    struct ScopedRealtimeSection
+    {
+        ScopedRealtimeSection();
+        ~ScopedRealtimeSection();
+        JUCE_DECLARE_NON_COPYABLE(ScopedRealtimeSection)
+    };
+
+    /*
+        temporarily permits allocations inside a ScopedRealtimeSection.
+        every use of this is a known real-time violation that still needs fixing.
+    */
+    struct ScopedAllowAllocation
+    {
+        ScopedAllowAllocation();
+        ~ScopedAllowAllocation();
+        JUCE_DECLARE_NON_COPYABLE(ScopedAllowAllocation)
+    };
+
+    // true if the calling thread is inside a ScopedRealtimeSection that doesn't allow allocations
+    static bool isInRealtimeSection();
+
+    // number of allocations that were made inside a realtime section since the process started.
+    static int getNumRealtimeAllocations();
+};
@@ -0,0 +1,293 @@
+/*
+  ==============================================================================
+
+    DeadlineTelemetry.cpp
+
+  ==============================================================================
+*/
+
+#include "DeadlineTelemetry.h"
+
+#if JUCE_INTEL
+ #include <xmmintrin.h>
+#endif
+
+#if JUCE_WINDOWS
+ #include <process.h>
+#else
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr size_t sharedSegmentSize = sizeof(DeadlineTelemetry::SharedHeader)
+                                       + DeadlineTelemetry::numSharedSlots * sizeof(DeadlineTelemetry::Counters)
+                                       + sizeof(juce::uint64);
+
+    static_assert(sizeof(DeadlineTelemetry::SharedHeader) % alignof(DeadlineTelemetry::Counters) == 0,
+                  "the slots follow the header without padding");
+
+    juce::uint64 getProcessId()
+    {
+       #if JUCE_WINDOWS
+        return static_cast<juce::uint64>(_getpid());
+       #else
+        return static_cast<juce::uint64>(getpid());
+       #endif
+    }
+
+    //the audio thread is the only writer, so there is no need for a locked read-modify-write
+    void increment(std::atomic<juce::uint64>& counter) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void copyCounters(const DeadlineTelemetry::Counters& source, DeadlineTelemetry::Counters& destination) noexcept
+    {
+        auto copy = [](const std::atomic<juce::uint64>& from, std::atomic<juce::uint64>& to)
+        {
+            to.store(from.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        };
+
+        copy(source.instanceId, destination.instanceId);
+        copy(source.numBlocks, destination.numBlocks);
+        copy(source.numDeadlineMisses, destination.numDeadlineMisses);
+        copy(source.longestBlockNanoseconds, destination.longestBlockNanoseconds);
+        copy(source.longestBlockBudgetNanoseconds, destination.longestBlockBudgetNanoseconds);
+        copy(source.numDenormalFlushBlocks, destination.numDenormalFlushBlocks);
+        copy(source.numNonFiniteBlocks, destination.numNonFiniteBlocks);
+    }
+}
+
+DeadlineTelemetry::DeadlineTelemetry(int instanceIdToPublish)
+    : instanceId(instanceIdToPublish)
+{
+    localCounters.instanceId.store(static_cast<juce::uint64>(instanceId), std::memory_order_relaxed);
+}
+
+DeadlineTelemetry::~DeadlineTelemetry()
+{
+    if (sharedSegment != nullptr)
+        counters->processId.store(0, std::memory_order_release);
+}
+
+juce::File DeadlineTelemetry::getSharedMemoryFile()
+{
+    const juce::String name("CAudioPlugin-telemetry");
+
+   #if JUCE_LINUX
+    const juce::File sharedMemoryDirectory("/dev/shm");
+    if (sharedMemoryDirectory.isDirectory())
+        return sharedMemoryDirectory.getChildFile(name);
+   #endif
+
+    return juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile(name);
+}
+
+bool DeadlineTelemetry::attachToSharedMemory()
+{
+    if (sharedSegment != nullptr)
+        return true;
+
+    auto file = getSharedMemoryFile();
+
+    /*
+        a zero byte at the very end sizes the file, the rest reads as zeros: an empty header and free slots.
+        the byte lands in the padding, so a process that sizes the file while another one is already using it changes nothing.
+    */
+    if (file.getSize() < static_cast<juce::int64>(sharedSegmentSize))
+    {
+        juce::FileOutputStream stream(file);
+        if (! stream.openedOk()
+            || ! stream.setPosition(static_cast<juce::int64>(sharedSegmentSize) - 1)
+            || ! stream.writeByte(0))
+            return false;
+    }
+
+    auto segment = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readWrite);
+    if (segment->getData() == nullptr || segment->getSize() < sharedSegmentSize)
+        return false;
+
+    auto* header = static_cast<SharedHeader*>(segment->getData());
+
+    //every process writes the same layout, so two of them setting up a new segment at once is harmless.
+    if (header->magic.load(std::memory_order_acquire) == 0)
+    {
+        header->version.store(sharedVersion, std::memory_order_relaxed);
+        header->numSlots.store(numSharedSlots, std::memory_order_relaxed);
+        header->slotSize.store(sizeof(Counters), std::memory_order_relaxed);
+
+        auto noDeadlineYet = juce::uint32(0);
+        header->deadlinePermille.compare_exchange_strong(noDeadlineYet, localDeadlinePermille.load(std::memory_order_relaxed));
+
+        header->magic.store(sharedMagic, std::memory_order_release);
+    }
+    else if (header->magic.load(std::memory_order_acquire) != sharedMagic
+             || header->version.load(std::memory_order_relaxed) != sharedVersion)
+    {
+        return false;
+    }
+
+    auto* slots = reinterpret_cast<Counters*>(header + 1);
+
+    for (juce::uint32 i = 0; i < numSharedSlots; ++i)
+    {
+        auto& slot = slots[i];
+
+        auto freeSlot = juce::uint64(0);
+        if (! slot.processId.compare_exchange_strong(freeSlot, claimingProcessId, std::memory_order_acq_rel))
+            continue;
+
+        //whatever a previous owner left in the slot is overwritten with what this instance counted so far.
+        copyCounters(localCounters, slot);
+        slot.processId.store(getProcessId(), std::memory_order_release);
+
+        counters = &slot;
+        deadlinePermille = &header->deadlinePermille;
+        sharedSegment = std::move(segment);
+        return true;
+    }
+
+    return false;
+}
+
+bool DeadlineTelemetry::attachToSharedMemoryIfRequested()
+{
+    if (juce::SystemStats::getEnvironmentVariable(sharedMemoryEnvironmentVariable, {}) != "1")
+        return false;
+
+    return attachToSharedMemory();
+}
+
+void DeadlineTelemetry::setDeadlineFraction(float newFraction) noexcept
+{
+    jassert(newFraction > 0.f);
+    deadlinePermille->store(static_cast<juce::uint32>(juce::jmax(newFraction, 0.001f) * 1000.f + 0.5f), std::memory_order_relaxed);
+}
+
+float DeadlineTelemetry::getDeadlineFraction() const noexcept
+{
+    return static_cast<float>(deadlinePermille->load(std::memory_order_relaxed)) * 0.001f;
+}
+
+DeadlineTelemetry::Snapshot DeadlineTelemetry::getSnapshot() const noexcept
+{
+    Snapshot snapshot;
+    snapshot.numBlocks = counters->numBlocks.load(std::memory_order_relaxed);
+    snapshot.numDeadlineMisses = counters->numDeadlineMisses.load(std::memory_order_relaxed);
+    snapshot.longestBlockNanoseconds = counters->longestBlockNanoseconds.load(std::memory_order_relaxed);
+    snapshot.longestBlockBudgetNanoseconds = counters->longestBlockBudgetNanoseconds.load(std::memory_order_relaxed);
+    snapshot.numDenormalFlushBlocks = counters->numDenormalFlushBlocks.load(std::memory_order_relaxed);
+    snapshot.numNonFiniteBlocks = counters->numNonFiniteBlocks.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void DeadlineTelemetry::recordBlock(juce::int64 elapsedTicks, double budgetSeconds, bool flushedDenormals, bool hasNonFiniteSamples) noexcept
+{
+    auto& blockCounters = *counters;
+
+    const auto elapsedNanoseconds = static_cast<juce::uint64>(juce::Time::highResolutionTicksToSeconds(elapsedTicks) * 1.0e9);
+    const auto budgetNanoseconds = static_cast<juce::uint64>(budgetSeconds * 1.0e9);
+    const auto deadlineNanoseconds = budgetNanoseconds * deadlinePermille->load(std::memory_order_relaxed) / 1000;
+
+    increment(blockCounters.numBlocks);
+
+    if (budgetNanoseconds > 0 && elapsedNanoseconds > deadlineNanoseconds)
+        increment(blockCounters.numDeadlineMisses);
+
+    if (elapsedNanoseconds > blockCounters.longestBlockNanoseconds.load(std::memory_order_relaxed))
+    {
+        blockCounters.longestBlockNanoseconds.store(elapsedNanoseconds, std::memory_order_relaxed);
+        blockCounters.longestBlockBudgetNanoseconds.store(budgetNanoseconds, std::memory_order_relaxed);
+    }
+
+    if (flushedDenormals)
+        increment(blockCounters.numDenormalFlushBlocks);
+
+    if (hasNonFiniteSamples)
+        increment(blockCounters.numNonFiniteBlocks);
+}
+
+/*
+    with flush-to-zero on, the FPU raises its underflow flag whenever it flushes a result,
+    and the denormal flag when it sees a denormal operand it didn't treat as zero.
+    both flags are sticky, so reading them once per block catches every flush in it, on this thread.
+    the worker pool's threads have flags of their own, which this doesn't see:
+    a flush in a channel group that ran on a worker isn't counted.
+*/
+bool DeadlineTelemetry::readAndClearDenormalFlags() noexcept
+{
+   #if JUCE_INTEL
+    constexpr unsigned int denormalFlag = 1 << 1, underflowFlag = 1 << 4;
+    const auto status = _mm_getcsr();
+    if ((status & (denormalFlag | underflowFlag)) == 0)
+        return false;
+
+    _mm_setcsr(status & ~(denormalFlag | underflowFlag));
+    return true;
+   #elif JUCE_ARM && defined(__aarch64__)
+    constexpr juce::uint64 underflowFlag = 1 << 3, inputDenormalFlag = 1 << 7;
+    juce::uint64 status;
+    asm volatile("mrs %0, fpsr" : "=r"(status));
+    if ((status & (underflowFlag | inputDenormalFlag)) == 0)
+        return false;
+
+    asm volatile("msr fpsr, %0" : : "r"(status & ~(underflowFlag | inputDenormalFlag)));
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+//compares the exponent bits, which -ffast-math can't optimise away the way it can std::isfinite
+template<typename SampleType>
+bool DeadlineTelemetry::containsNonFiniteSamples(const juce::AudioBuffer<SampleType>& buffer) noexcept
+{
+    using Bits = std::conditional_t<sizeof(SampleType) == sizeof(juce::uint32), juce::uint32, juce::uint64>;
+    constexpr Bits exponentMask = sizeof(SampleType) == sizeof(juce::uint32) ? Bits(0x7f800000)
+                                                                             : Bits(0x7ff0000000000000);
+
+    const auto numSamples = buffer.getNumSamples();
+
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        const auto* samples = buffer.getReadPointer(ch);
+        bool found = false;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            Bits bits;
+            std::memcpy(&bits, samples + i, sizeof(Bits));
+            found |= (bits & exponentMask) == exponentMask;
+        }
+
+        if (found)
+            return true;
+    }
+
+    return false;
+}
+
+//==============================================================================
+template<typename SampleType>
+DeadlineTelemetry::ScopedBlock<SampleType>::ScopedBlock(DeadlineTelemetry& telemetryToUse, const juce::AudioBuffer<SampleType>& bufferToCheck, double sampleRate) noexcept
+    : telemetry(telemetryToUse),
+      buffer(bufferToCheck),
+      budgetSeconds(sampleRate > 0.0 ? bufferToCheck.getNumSamples() / sampleRate : 0.0)
+{
+    //whatever raised the flags before this block isn't counted against it
+    readAndClearDenormalFlags();
+    startTicks = juce::Time::getHighResolutionTicks();
+}
+
+template<typename SampleType>
+DeadlineTelemetry::ScopedBlock<SampleType>::~ScopedBlock()
+{
+    const auto elapsedTicks = juce::Time::getHighResolutionTicks() - startTicks;
+    const auto flushedDenormals = readAndClearDenormalFlags();
+
+    telemetry.recordBlock(elapsedTicks, budgetSeconds, flushedDenormals, containsNonFiniteSamples(buffer));
+}
+
+template struct DeadlineTelemetry::ScopedBlock<float>;
+template struct DeadlineTelemetry::ScopedBlock<double>;
@@ -0,0 +1,148 @@
+/*
+  ==============================================================================
+
+    DeadlineTelemetry.h
+
+    Always-on counters for how close the audio thread runs to its deadline.
+    Every processBlock counts as one block. The counters track:
+    - blocks that took longer than a fraction of their budget (numSamples / sampleRate)
+    - the longest block so far
+    - blocks in which the FPU flushed a denormal to zero
+    - blocks that left a NaN or an infinity in the output
+    The audio thread is the only writer, and every counter is a relaxed atomic,
+    so a block costs two timer reads, two FPU status accesses and one pass over the output.
+
+    The counters can also be published in a shared-memory segment (a memory
+    mapped file in /dev/shm, or the temp directory where there is none).
+    Each instance on the machine claims one slot in it, so a local monitoring
+    daemon can scrape all of them without going through the host.
+    The daemon can also set the deadline fraction for every instance in the segment's header.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct DeadlineTelemetry
+{
+    // the instance id ends up in the shared slot, next to the process id.
+    explicit DeadlineTelemetry(int instanceId);
+    ~DeadlineTelemetry();
+
+    /*
+        claims a slot in the shared segment, creating the segment if it isn't there yet.
+        message thread, before processing starts. returns false if the segment
+        can't be mapped or every slot is taken; the counters then stay in this instance.
+    */
+    bool attachToSharedMemory();
+
+    // set the environment variable to 1 and every instance created afterwards attaches.
+    static constexpr const char* sharedMemoryEnvironmentVariable = "CAUDIOPLUGIN_TELEMETRY";
+    bool attachToSharedMemoryIfRequested();
+
+    /*
+        the fraction of the block budget a block may use before it counts as a deadline miss.
+        once attached, this is the segment's fraction, shared by every instance in it.
+    */
+    void setDeadlineFraction(float newFraction) noexcept;
+    float getDeadlineFraction() const noexcept;
+
+    //==============================================================================
+    /*
+        put one of these at the top of processBlock, after the ScopedNoDenormals.
+        the buffer is checked for non-finite samples when it goes out of scope.
+    */
+    template<typename SampleType>
+    struct ScopedBlock
+    {
+        ScopedBlock(DeadlineTelemetry& telemetryToUse, const juce::AudioBuffer<SampleType>& bufferToCheck, double sampleRate) noexcept;
+        ~ScopedBlock();
+
+        DeadlineTelemetry& telemetry;
+        const juce::AudioBuffer<SampleType>& buffer;
+        const double budgetSeconds;
+        juce::int64 startTicks = 0;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedBlock)
+    };
+
+    //==============================================================================
+    /*
+        the layout of one slot in the shared segment. every field is a lock-free atomic,
+        so the daemon reads them with plain 64-bit loads.
+    */
+    struct Counters
+    {
+        std::atomic<juce::uint64> processId{ 0 }; // 0 while the slot is free, claimingProcessId while it is being set up
+        std::atomic<juce::uint64> instanceId{ 0 };
+        std::atomic<juce::uint64> numBlocks{ 0 };
+        std::atomic<juce::uint64> numDeadlineMisses{ 0 };
+        std::atomic<juce::uint64> longestBlockNanoseconds{ 0 };
+        std::atomic<juce::uint64> longestBlockBudgetNanoseconds{ 0 }; // the budget of that longest block
+        std::atomic<juce::uint64> numDenormalFlushBlocks{ 0 };
+        std::atomic<juce::uint64> numNonFiniteBlocks{ 0 };
+    };
+
+    static_assert(std::atomic<juce::uint64>::is_always_lock_free, "the counters are shared between processes");
+
+    struct Snapshot
+    {
+        juce::uint64 numBlocks = 0;
+        juce::uint64 numDeadlineMisses = 0;
+        juce::uint64 longestBlockNanoseconds = 0;
+        juce::uint64 longestBlockBudgetNanoseconds = 0;
+        juce::uint64 numDenormalFlushBlocks = 0;
+        juce::uint64 numNonFiniteBlocks = 0;
+    };
+
+    Snapshot getSnapshot() const noexcept;
+
+    static constexpr float defaultDeadlineFraction = 0.8f;
+
+    /*
+        the segment is a header followed by numSharedSlots Counters and 8 bytes of padding.
+        the version changes whenever this layout does; a process that finds another version leaves the segment alone.
+        slots whose process has died stay claimed until the daemon clears their processId.
+    */
+    static constexpr juce::uint32 sharedMagic = 0x43415054; // "CAPT"
+    static constexpr juce::uint32 sharedVersion = 1;
+    static constexpr juce::uint32 numSharedSlots = 256;
+    static constexpr juce::uint64 claimingProcessId = ~juce::uint64(0);
+
+    struct SharedHeader
+    {
+        std::atomic<juce::uint32> magic{ 0 };
+        std::atomic<juce::uint32> version{ 0 };
+        std::atomic<juce::uint32> numSlots{ 0 };
+        std::atomic<juce::uint32> slotSize{ 0 };
+        std::atomic<juce::uint32> deadlinePermille{ 0 };
+        std::atomic<juce::uint32> reserved{ 0 };
+    };
+
+    static juce::File getSharedMemoryFile();
+
+private:
+    // called by ScopedBlock
+    void recordBlock(juce::int64 elapsedTicks, double budgetSeconds, bool flushedDenormals, bool hasNonFiniteSamples) noexcept;
+
+    // clears the FPU's sticky underflow and denormal flags, and reports whether either was set since the last clear.
+    static bool readAndClearDenormalFlags() noexcept;
+
+    template<typename SampleType>
+    static bool containsNonFiniteSamples(const juce::AudioBuffer<SampleType>& buffer) noexcept;
+
+    const int instanceId;
+
+    Counters localCounters;
+    std::atomic<juce::uint32> localDeadlinePermille{ static_cast<juce::uint32>(defaultDeadlineFraction * 1000.f) };
+
+    //point into the shared segment once attached, at the local copies otherwise
+    Counters* counters = &localCounters;
+    std::atomic<juce::uint32>* deadlinePermille = &localDeadlinePermille;
+
+    std::unique_ptr<juce::MemoryMappedFile> sharedSegment;
+
+    JUCE_DECLARE_NON_COPYABLE(DeadlineTelemetry)
+};
@@ -0,0 +1,205 @@
+/*
+  ==============================================================================
+
+    StageProfiler.cpp
+
+  ==============================================================================
+*/
+
+#include "StageProfiler.h"
+
+namespace
+{
+    std::atomic<int> nextInstanceId{ 1 };
+
+    //the cycle counter is only calibrated once it has run for this long, a shorter span gives a noisy rate.
+    constexpr double minCalibrationSeconds = 0.05;
+}
+
+StageProfiler::StageProfiler()
+    : instanceId(nextInstanceId.fetch_add(1)),
+      calibrationStartTicks(now()),
+      calibrationStartTime(juce::Time::getHighResolutionTicks())
+{
+    statistics.instanceId = instanceId;
+}
+
+void StageProfiler::setEnabled(bool shouldBeEnabled)
+{
+    if (shouldBeEnabled && ring == nullptr)
+    {
+        ring = std::make_unique<Slot[]>(ringSize);
+
+        for (auto& sectionHistory : history)
+            sectionHistory.reserve(historySize);
+
+        sortScratch.reserve(historySize);
+    }
+
+    //release: the audio thread sees the ring before it sees the flag
+    enabled.store(shouldBeEnabled, std::memory_order_release);
+}
+
+/*
+    a seqlock per slot. the sequence is cleared before the payload is written and set after,
+    so the collector can tell a finished timing from one being written or overwritten.
+*/
+void StageProfiler::record(ProfiledSection section, Ticks start, Ticks end) noexcept
+{
+    const auto position = writePosition.fetch_add(1, std::memory_order_relaxed);
+    auto& slot = ring[position & (ringSize - 1)];
+
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.payload.store(((end - start) << 8) | static_cast<juce::uint64>(section), std::memory_order_relaxed);
+    slot.sequence.store(position + 1, std::memory_order_release);
+}
+
+void StageProfiler::addProcessedSamples(int numSamples, double sampleRate) noexcept
+{
+    if (sampleRate > 0.0)
+        audioNanoseconds.fetch_add(static_cast<juce::uint64>(numSamples * 1.0e9 / sampleRate), std::memory_order_relaxed);
+}
+
+const StageProfiler::Statistics& StageProfiler::collect()
+{
+    if (ring == nullptr)
+        return statistics;
+
+    /*
+        the counter rate is measured against the high resolution timer over the profiler's lifetime.
+        until that span is long enough, timings stay in the ring.
+    */
+    const auto elapsedSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - calibrationStartTime);
+    if (elapsedSeconds < minCalibrationSeconds)
+        return statistics;
+
+    ticksPerMicrosecond = static_cast<double>(now() - calibrationStartTicks) / (elapsedSeconds * 1.0e6);
+
+    const auto endPosition = writePosition.load(std::memory_order_acquire);
+    if (endPosition - readPosition > ringSize)
+    {
+        statistics.numDropped += static_cast<juce::int64>(endPosition - readPosition - ringSize);
+        readPosition = endPosition - ringSize;
+    }
+
+    ticksSinceLastCollect.fill(0.0);
+
+    for (; readPosition < endPosition; ++readPosition)
+    {
+        auto& slot = ring[readPosition & (ringSize - 1)];
+
+        //0 or an older position: claimed but not written yet, it is picked up next time.
+        const auto sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence == 0 || sequence < readPosition + 1)
+            break;
+
+        const auto payload = slot.payload.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        //a later position, or a writer got in while the payload was read: overwritten.
+        if (sequence != readPosition + 1 || slot.sequence.load(std::memory_order_relaxed) != sequence)
+        {
+            ++statistics.numDropped;
+            continue;
+        }
+
+        const auto section = static_cast<size_t>(payload & 0xff);
+        const auto ticks = static_cast<double>(payload >> 8);
+        if (section >= numSections)
+            continue;
+
+        auto& sectionHistory = history[section];
+        auto& historyPosition = historyWritePosition[section];
+        const auto microseconds = static_cast<float>(ticks / ticksPerMicrosecond);
+
+        if (sectionHistory.size() < historySize)
+            sectionHistory.push_back(microseconds);
+        else
+            sectionHistory[historyPosition] = microseconds;
+
+        historyPosition = (historyPosition + 1) % historySize;
+        ticksSinceLastCollect[section] += ticks;
+        ++statistics.sections[section].count;
+    }
+
+    const auto currentAudioNanoseconds = audioNanoseconds.load(std::memory_order_relaxed);
+    const auto audioMicroseconds = static_cast<double>(currentAudioNanoseconds - lastAudioNanoseconds) * 1.0e-3;
+    lastAudioNanoseconds = currentAudioNanoseconds;
+    statistics.audioSeconds = audioMicroseconds * 1.0e-6;
+
+    for (size_t i = 0; i < numSections; ++i)
+    {
+        auto& section = statistics.sections[i];
+        const auto& sectionHistory = history[i];
+
+        //a section that didn't run since the last collect keeps its statistics, but not its share of the budget
+        if (audioMicroseconds > 0.0)
+            section.budgetPercent = 100.0 * ticksSinceLastCollect[i] / ticksPerMicrosecond / audioMicroseconds;
+
+        if (sectionHistory.empty())
+            continue;
+
+        sortScratch.assign(sectionHistory.begin(), sectionHistory.end());
+
+        double sum = 0.0;
+        for (auto microseconds : sortScratch)
+            sum += microseconds;
+
+        section.meanMicroseconds = sum / static_cast<double>(sortScratch.size());
+
+        const auto p99Index = (sortScratch.size() * 99 + 99) / 100 - 1;
+        std::nth_element(sortScratch.begin(), sortScratch.begin() + static_cast<std::ptrdiff_t>(p99Index), sortScratch.end());
+        section.p99Microseconds = sortScratch[p99Index];
+        section.maxMicroseconds = *std::max_element(sortScratch.begin() + static_cast<std::ptrdiff_t>(p99Index), sortScratch.end());
+    }
+
+    return statistics;
+}
+
+const char* StageProfiler::getSectionName(ProfiledSection section)
+{
+    switch (section)
+    {
+        case ProfiledSection::Phaser: return "Phaser";
+        case ProfiledSection::Chorus: return "Chorus";
+        case ProfiledSection::OverDrive: return "Overdrive";
+        case ProfiledSection::LadderFilter: return "Ladder Filter";
+        case ProfiledSection::GeneralFilter: return "General Filter";
+        case ProfiledSection::Delay: return "Delay";
+        case ProfiledSection::SmootherUpdate: return "Smoother Update";
+        case ProfiledSection::CoefficientUpdate: return "Coefficient Update";
+        case ProfiledSection::ProcessBlock: return "processBlock";
+        case ProfiledSection::END_OF_LIST: break;
+    }
+
+    jassertfalse;
+    return "";
+}
+
+juce::String StageProfiler::toJSON(const Statistics& statisticsToWrite)
+{
+    juce::Array<juce::var> sections;
+    for (size_t i = 0; i < numSections; ++i)
+    {
+        const auto& section = statisticsToWrite.sections[i];
+
+        auto* object = new juce::DynamicObject();
+        object->setProperty("name", getSectionName(static_cast<ProfiledSection>(i)));
+        object->setProperty("count", section.count);
+        object->setProperty("mean_us", section.meanMicroseconds);
+        object->setProperty("p99_us", section.p99Microseconds);
+        object->setProperty("max_us", section.maxMicroseconds);
+        object->setProperty("budget_percent", section.budgetPercent);
+        sections.add(juce::var(object));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("instance", statisticsToWrite.instanceId);
+    root->setProperty("audio_seconds", statisticsToWrite.audioSeconds);
+    root->setProperty("dropped", statisticsToWrite.numDropped);
+    root->setProperty("sections", sections);
+
+    return juce::JSON::toString(juce::var(root));
+}
@@ -0,0 +1,179 @@
+/*
+  ==============================================================================
+
+    StageProfiler.h
+
+    Where the time goes inside one processor instance.
+    The audio thread and the worker pool time every chain stage, the smoother
+    and coefficient updates and the whole processBlock with the CPU's cycle
+    counter, and write each timing into a lock-free ring. Writing never
+    blocks or allocates. If the collector falls behind, the oldest timings
+    are overwritten and counted as dropped.
+    collect() drains the ring on the message thread. Per section it computes
+    mean, p99 and max over the most recent timings, and the share of the
+    block budget (the audio time processed since the last collect) that the
+    section used. Sections that run on several workers at once add up, so
+    the stage shares can total more than processBlock's.
+    Profiling is off until setEnabled(true), which is also when the ring and
+    the history are allocated. When it's off, a ScopedTimer costs one load.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+//the first six match DSP_Option, so a chain stage converts straight across.
+enum class ProfiledSection
+{
+    Phaser,
+    Chorus,
+    OverDrive,
+    LadderFilter,
+    GeneralFilter,
+    Delay,
+    SmootherUpdate,
+    CoefficientUpdate,
+    ProcessBlock,
+    END_OF_LIST
+};
+
+struct StageProfiler
+{
+    using Ticks = juce::uint64;
+
+    static constexpr size_t numSections = static_cast<size_t>(ProfiledSection::END_OF_LIST);
+
+    //about 3 seconds of timings at 64-sample sub-blocks, enough for a collector that polls a few times a second.
+    static constexpr size_t ringSize = 1 << 14;
+
+    //the statistics cover this many of the most recent timings of each section.
+    static constexpr size_t historySize = 4096;
+
+    StageProfiler();
+
+    // message thread. the first call allocates the ring.
+    void setEnabled(bool shouldBeEnabled);
+    bool isEnabled() const noexcept { return enabled.load(std::memory_order_acquire); }
+
+    // numbered in creation order, so the numbers from several instances in one session can be told apart.
+    int getInstanceId() const noexcept { return instanceId; }
+
+    // the cycle counter on x86 and ARM64, the high resolution timer elsewhere. collect() calibrates it.
+    static Ticks now() noexcept
+    {
+       #if JUCE_INTEL
+        return static_cast<Ticks>(__rdtsc());
+       #elif JUCE_ARM && defined(__aarch64__)
+        Ticks ticks;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+        return ticks;
+       #else
+        return static_cast<Ticks>(juce::Time::getHighResolutionTicks());
+       #endif
+    }
+
+    //==============================================================================
+    // audio side. safe to call from any number of threads at once, once isEnabled() has returned true.
+
+    void record(ProfiledSection section, Ticks start, Ticks end) noexcept;
+
+    // the audio time processBlock covered, i.e. the budget the sections are measured against.
+    void addProcessedSamples(int numSamples, double sampleRate) noexcept;
+
+    // times its scope. a null profiler, or one that isn't enabled, isn't touched again.
+    struct ScopedTimer
+    {
+        ScopedTimer(StageProfiler* profilerToUse, ProfiledSection sectionToTime) noexcept
+            : profiler(profilerToUse != nullptr && profilerToUse->isEnabled() ? profilerToUse : nullptr),
+              section(sectionToTime),
+              start(profiler != nullptr ? now() : 0)
+        {
+        }
+
+        ~ScopedTimer()
+        {
+            if (profiler != nullptr)
+                profiler->record(section, start, now());
+        }
+
+        StageProfiler* const profiler;
+        const ProfiledSection section;
+        const Ticks start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedTimer)
+    };
+
+    //==============================================================================
+    // message thread side.
+
+    struct SectionStatistics
+    {
+        juce::int64 count = 0; // every timing collected so far
+        double meanMicroseconds = 0.0;
+        double p99Microseconds = 0.0;
+        double maxMicroseconds = 0.0;
+        double budgetPercent = 0.0;
+    };
+
+    struct Statistics
+    {
+        int instanceId = 0;
+        double audioSeconds = 0.0; // since the last collect
+        juce::int64 numDropped = 0; // overwritten before they were collected, since profiling started
+
+        //indexed by ProfiledSection
+        std::array<SectionStatistics, numSections> sections;
+    };
+
+    // drains the ring and updates the statistics. not realtime safe, and only one thread may call it.
+    const Statistics& collect();
+
+    static const char* getSectionName(ProfiledSection section);
+
+    static juce::String toJSON(const Statistics& statisticsToWrite);
+
+private:
+    struct Slot
+    {
+        //position + 1 once the payload is written, 0 while it is being written
+        std::atomic<juce::uint64> sequence{ 0 };
+
+        //duration in ticks << 8 | section
+        std::atomic<juce::uint64> payload{ 0 };
+    };
+
+    std::atomic<bool> enabled{ false };
+    const int instanceId;
+
+    std::unique_ptr<Slot[]> ring;
+    std::atomic<juce::uint64> writePosition{ 0 };
+    std::atomic<juce::uint64> audioNanoseconds{ 0 };
+
+    //collector state
+    juce::uint64 readPosition = 0;
+    juce::uint64 lastAudioNanoseconds = 0;
+
+    Ticks calibrationStartTicks = 0;
+    juce::int64 calibrationStartTime = 0;
+    double ticksPerMicrosecond = 0.0;
+
+    //every timing in microseconds, per section, oldest overwritten first
+    std::array<std::vector<float>, numSections> history;
+    std::array<size_t, numSections> historyWritePosition{};
+    std::array<double, numSections> ticksSinceLastCollect{};
+    std::vector<float> sortScratch;
+
+    Statistics statistics;
+
+    JUCE_DECLARE_NON_COPYABLE(StageProfiler)
+};
@@ -31,6 +31,9 @@ static juce::String getNameFromDSPOption(CAudioPluginAudioProcessor::DSP_Option
         case CAudioPluginAudioProcessor::DSP_Option::GeneralFilter:
             return "GEN FILTER";
             break;
+        case CAudioPluginAudioProcessor::DSP_Option::Delay:
+            return "DELAY";
+            break;
         case CAudioPluginAudioProcessor::DSP_Option::END_OF_LIST:
             jassertfalse;
     }
@@ -49,6 +52,8 @@ static CAudioPluginAudioProcessor::DSP_Option getDSPOptionFromName(juce::String
         return CAudioPluginAudioProcessor::DSP_Option::LadderFilter;
     if (name == "GEN FILTER")
         return CAudioPluginAudioProcessor::DSP_Option::GeneralFilter;
+    if (name == "DELAY")
+        return CAudioPluginAudioProcessor::DSP_Option::Delay;
     
     return CAudioPluginAudioProcessor::DSP_Option::END_OF_LIST;
 }
@@ -626,6 +631,85 @@ void DSP_Gui::toggleSliderEnablement(bool enabled)
 
 }
 
+//==============================================================================
+ProfilerOverlay::ProfilerOverlay(StageProfiler& profilerToShow) : profiler(profilerToShow)
+{
+    setInterceptsMouseClicks(false, true);
+    addAndMakeVisible(copyButton);
+
+    copyButton.onClick = [this]()
+    {
+        juce::SystemClipboard::copyTextToClipboard(StageProfiler::toJSON(statistics));
+    };
+}
+
+ProfilerOverlay::~ProfilerOverlay()
+{
+    profiler.setEnabled(false);
+}
+
+void ProfilerOverlay::visibilityChanged()
+{
+    profiler.setEnabled(isVisible());
+
+    if (isVisible())
+        startTimerHz(refreshRateHz);
+    else
+        stopTimer();
+}
+
+void ProfilerOverlay::timerCallback()
+{
+    statistics = profiler.collect();
+    repaint();
+}
+
+void ProfilerOverlay::resized()
+{
+    copyButton.setBounds(getLocalBounds().removeFromTop(24).removeFromRight(100).reduced(2));
+}
+
+void ProfilerOverlay::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black.withAlpha(0.8f));
+    g.setFont(13.f);
+
+    auto bounds = getLocalBounds().reduced(8, 4);
+
+    g.setColour(juce::Colours::white);
+    g.drawText("instance #" + juce::String(statistics.instanceId)
+               + "   dropped: " + juce::String(statistics.numDropped),
+               bounds.removeFromTop(rowHeight), juce::Justification::centredLeft);
+
+    auto drawRow = [&g, &bounds](const juce::StringArray& columns)
+    {
+        auto row = bounds.removeFromTop(rowHeight);
+        auto nameWidth = row.getWidth() / 3;
+        auto columnWidth = (row.getWidth() - nameWidth) / juce::jmax(1, columns.size() - 1);
+
+        g.drawText(columns[0], row.removeFromLeft(nameWidth), juce::Justification::centredLeft);
+        for (int i = 1; i < columns.size(); ++i)
+            g.drawText(columns[i], row.removeFromLeft(columnWidth), juce::Justification::centredRight);
+    };
+
+    bounds.removeFromTop(rowHeight / 2);
+    g.setColour(juce::Colours::lightsteelblue);
+    drawRow({ "section", "mean us", "p99 us", "max us", "% budget" });
+
+    for (size_t i = 0; i < StageProfiler::numSections; ++i)
+    {
+        const auto& section = statistics.sections[i];
+
+        //a stage that never ran (e.g. it is bypassed) is greyed out
+        g.setColour(section.count > 0 ? juce::Colours::white : juce::Colours::grey);
+        drawRow({ StageProfiler::getSectionName(static_cast<ProfiledSection>(i)),
+                  juce::String(section.meanMicroseconds, 2),
+                  juce::String(section.p99Microseconds, 2),
+                  juce::String(section.maxMicroseconds, 2),
+                  juce::String(section.budgetPercent, 1) });
+    }
+}
+
 //==============================================================================
 CAudioPluginAudioProcessorEditor::CAudioPluginAudioProcessorEditor (CAudioPluginAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p)
@@ -636,6 +720,7 @@ CAudioPluginAudioProcessorEditor::CAudioPluginAudioProcessorEditor (CAudioPlugin
     addAndMakeVisible(tabbedComponent);
     addAndMakeVisible(dspGUI);
     addAndMakeVisible(analyzer);
+    addChildComponent(profilerOverlay);
 
     inGainControl = std::make_unique<RotarySliderWithLabels>(audioProcessor.inputGain, "dB", "IN");
     outGainControl = std::make_unique<RotarySliderWithLabels>(audioProcessor.outputGain, "dB", "OUT");
@@ -652,6 +737,7 @@ CAudioPluginAudioProcessorEditor::CAudioPluginAudioProcessorEditor (CAudioPlugin
     audioProcessor.guiNeedsLatestDspOrder.set(true);
 
     tabbedComponent.addListener(this);
+    setWantsKeyboardFocus(true);
     startTimerHz(30);
     setSize (768, 450);
 }
@@ -784,11 +870,23 @@ void CAudioPluginAudioProcessorEditor::resized()
     outGainControl->setBounds(rightMeterArea.removeFromBottom(ioControlSize));
 
     analyzer.setBounds(bounds.removeFromTop(bounds.getHeight() * 0.7));
+    profilerOverlay.setBounds(analyzer.getBounds());
 
     tabbedComponent.setBounds(bounds.removeFromTop(30));
     dspGUI.setBounds(bounds);
 }
 
+bool CAudioPluginAudioProcessorEditor::keyPressed(const juce::KeyPress& key)
+{
+    if (key == juce::KeyPress('p', juce::ModifierKeys::commandModifier | juce::ModifierKeys::shiftModifier, 0))
+    {
+        profilerOverlay.setVisible(! profilerOverlay.isVisible());
+        return true;
+    }
+
+    return false;
+}
+
 void CAudioPluginAudioProcessorEditor::tabOrderChanged(CAudioPluginAudioProcessor::DSP_Order newOrder)
 {
     rebuildInterface();
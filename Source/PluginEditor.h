@@ -142,6 +142,28 @@ struct DSP_Gui : juce::Component
     std::vector<juce::RangedAudioParameter*> currentParams;
 };
 
+/*
+    developer overlay for the processor's StageProfiler, toggled with cmd/ctrl+shift+P.
+    profiling only runs while it is visible. "Copy JSON" puts StageProfiler::toJSON() on the clipboard.
+*/
+struct ProfilerOverlay : juce::Component, juce::Timer
+{
+    ProfilerOverlay(StageProfiler& profilerToShow);
+    ~ProfilerOverlay() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    void visibilityChanged() override;
+    void timerCallback() override;
+
+    StageProfiler& profiler;
+    StageProfiler::Statistics statistics;
+    juce::TextButton copyButton{ "Copy JSON" };
+
+    static constexpr int refreshRateHz = 4;
+    static constexpr int rowHeight = 16;
+};
+
 //==============================================================================
 /**
 */
@@ -169,6 +191,7 @@ public:
     void selectedTabChanged(int newCurrentTabIndex) override;
 
     void timerCallback() override;
+    bool keyPressed(const juce::KeyPress& key) override;
 
 private:
     // This reference is provided as a quick way for your editor to
@@ -196,6 +219,8 @@ private:
 
     std::unique_ptr<juce::ParameterAttachment> selectedTabAttachment;
 
+    ProfilerOverlay profilerOverlay{ audioProcessor.profiler };
+
     void addTabsFromDSPOrder(CAudioPluginAudioProcessor::DSP_Order);
     void rebuildInterface();
     void refreshDSPGUIControlEnablement(PowerButtonWithParam* button);
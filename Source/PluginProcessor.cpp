@@ -8,6 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "Diagnostics/AllocationTracker.h"
 
 auto getPhaserRateName() { return juce::String("Phaser RateHz"); }
 auto getPhaserCenterFreqName() { return juce::String("Phaser Center FreqHz"); }
@@ -25,6 +26,26 @@ auto getChorusBypassName() { return juce::String("Chorus Bypass"); }
 
 auto getOverdriveSaturationName() { return juce::String("OverDrive Saturation"); }
 auto getOverdriveBypassName() { return juce::String("Overdrive Bypass"); }
+auto getOverdriveOversamplingName() { return juce::String("Overdrive Oversampling"); }
+auto getOverdriveOversamplingFilterName() { return juce::String("Overdrive Oversampling Filter"); }
+
+auto getOverdriveOversamplingChoices() {
+    return juce::StringArray
+    {
+        "1x",
+        "2x",
+        "4x",
+        "8x"
+    };
+}
+
+auto getOverdriveOversamplingFilterChoices() {
+    return juce::StringArray
+    {
+        "Polyphase IIR",  // low latency, not linear phase
+        "FIR"             // linear phase, more latency
+    };
+}
 
 auto getLadderFilterModeName() { return juce::String("Ladder Filter Mode"); }
 auto getLadderFilterCutoffName() { return juce::String("Ladder Filter Cutoff Hz"); }
@@ -59,8 +80,97 @@ auto getGeneralFilterQualityName() { return juce::String("General Filter Quality
 auto getGeneralFilterGainName() { return juce::String("General Filter Gain"); }
 auto getGeneralFilterBypassName() { return juce::String("General Filter Bypass"); }
 
+auto getDelayTimeName() { return juce::String("Delay Time Ms"); }
+auto getDelaySyncName() { return juce::String("Delay Sync"); }
+auto getDelayNoteName() { return juce::String("Delay Note"); }
+auto getDelayFeedbackName() { return juce::String("Delay Feedback %"); }
+auto getDelayLowCutName() { return juce::String("Delay Low Cut Hz"); }
+auto getDelayHighCutName() { return juce::String("Delay High Cut Hz"); }
+auto getDelayModulationRateName() { return juce::String("Delay Mod Rate Hz"); }
+auto getDelayModulationDepthName() { return juce::String("Delay Mod Depth Ms"); }
+auto getDelayMixName() { return juce::String("Delay Mix %"); }
+auto getDelayModeName() { return juce::String("Delay Mode"); }
+auto getDelayInterpolationName() { return juce::String("Delay Interpolation"); }
+auto getDelayBypassName() { return juce::String("Delay Bypass"); }
+
+auto getDelaySyncChoices() {
+    return juce::StringArray
+    {
+        "Free",
+        "Tempo"
+    };
+}
+
+auto getDelayNoteChoices() {
+    return juce::StringArray
+    {
+        "1/32",
+        "1/16T",
+        "1/16",
+        "1/8T",
+        "1/16D",
+        "1/8",
+        "1/4T",
+        "1/8D",
+        "1/4",
+        "1/2T",
+        "1/4D",
+        "1/2",
+        "1/2D",
+        "1/1"
+    };
+}
+
+//in beats, in getDelayNoteChoices() order
+double getDelayNoteLengthInBeats(int index)
+{
+    static constexpr std::array<double, 14> lengths
+    {
+        1.0 / 8.0, 1.0 / 6.0, 1.0 / 4.0, 1.0 / 3.0, 3.0 / 8.0, 1.0 / 2.0, 2.0 / 3.0,
+        3.0 / 4.0, 1.0, 4.0 / 3.0, 3.0 / 2.0, 2.0, 3.0, 4.0
+    };
+
+    //slower than this, the longest notes are capped at the length of the delay line.
+    constexpr auto minSyncedTempoBpm = 30.0;
+    static_assert(60000.0 / minSyncedTempoBpm * lengths.back() <= ModulatedDelay<float>::maxDelayMs,
+                  "the delay line has to fit every synced note at the slowest supported tempo");
+
+    return lengths[static_cast<size_t>(juce::jlimit(0, static_cast<int>(lengths.size()) - 1, index))];
+}
+
+auto getDelayModeChoices() {
+    return juce::StringArray
+    {
+        "Stereo",
+        "Ping-Pong"
+    };
+}
+
+auto getDelayInterpolationChoices() {
+    return juce::StringArray
+    {
+        "Lagrange",  // 3rd order, clean under fast modulation
+        "Thiran"     // allpass, flat response for slow changes
+    };
+}
+
 auto getSelectedTabName() { return juce::String("Selected Tab"); }
 
+auto getReorderCrossfadeName() { return juce::String("Reorder Crossfade Ms"); }
+
+auto getParallelProcessingName() { return juce::String("Parallel Processing"); }
+
+auto getControlRateGranularityName() { return juce::String("Control Rate Granularity"); }
+auto getControlRateGranularityChoices() {
+    return juce::StringArray
+    {
+        "8",
+        "16",
+        "32",
+        "64"
+    };
+}
+
 auto getInputGainName() { return juce::String("Input gain dB"); }
 auto getOutputGainName() { return juce::String("Output gain dB"); }
 
@@ -112,6 +222,14 @@ CAudioPluginAudioProcessor::CAudioPluginAudioProcessor()
         &generalFilterQuality,
         &generalFilterGain,
 
+        &delayTimeMs,
+        &delayFeedbackPercent,
+        &delayLowCutHz,
+        &delayHighCutHz,
+        &delayModulationRateHz,
+        &delayModulationDepthMs,
+        &delayMixPercent,
+
         &inputGain,
         &outputGain,
     };
@@ -141,22 +259,52 @@ CAudioPluginAudioProcessor::CAudioPluginAudioProcessor()
         &getGeneralFilterQualityName,
         &getGeneralFilterGainName,
 
+        &getDelayTimeName,
+        &getDelayFeedbackName,
+        &getDelayLowCutName,
+        &getDelayHighCutName,
+        &getDelayModulationRateName,
+        &getDelayModulationDepthName,
+        &getDelayMixName,
+
         &getInputGainName,
         &getOutputGainName,
     };
 
     initCachedParams<juce::AudioParameterFloat*>(floatParams, floatNameFuncs);
 
+    /*
+        floatParams is listed in SmoothedParam order, so it also builds the smoother binding table.
+        the in/out gains come last and aren't in the bank: their MeteredGain stages ramp them per sample.
+    */
+    static_assert(std::tuple_size_v<decltype(floatParams)> == NumSmoothedParams + 2);
+    for (size_t i = 0; i < smoothedParams.size(); ++i)
+    {
+        smoothedParams[i] = *floatParams[i];
+    }
+
     auto choiceParams = std::array
     {
         &ladderFilterMode,
         &generalFilterMode,
+        &overdriveOversampling,
+        &overdriveOversamplingFilter,
+        &delaySync,
+        &delayNote,
+        &delayMode,
+        &delayInterpolation,
     };
 
     auto choiceNameFuncs = std::array
     {
         &getLadderFilterModeName,
         &getGeneralFilterModeName,
+        &getOverdriveOversamplingName,
+        &getOverdriveOversamplingFilterName,
+        &getDelaySyncName,
+        &getDelayNoteName,
+        &getDelayModeName,
+        &getDelayInterpolationName,
     };
     
     initCachedParams<juce::AudioParameterChoice*>(choiceParams, choiceNameFuncs);
@@ -168,6 +316,7 @@ CAudioPluginAudioProcessor::CAudioPluginAudioProcessor()
         &overdriveBypass,
         &ladderFilterBypass,
         &generalFilterBypass,
+        &delayBypass,
     };
 
     auto bypassNameFuncs = std::array
@@ -177,10 +326,20 @@ CAudioPluginAudioProcessor::CAudioPluginAudioProcessor()
         &getOverdriveBypassName,
         &getLadderFilterBypassName,
         &getGeneralFilterBypassName,
+        &getDelayBypassName,
     };
 
     initCachedParams<juce::AudioParameterBool*>(bypassParams, bypassNameFuncs);
 
+    controlRateGranularity = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter(getControlRateGranularityName()));
+    jassert(controlRateGranularity != nullptr);
+
+    reorderCrossfadeMs = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter(getReorderCrossfadeName()));
+    jassert(reorderCrossfadeMs != nullptr);
+
+    parallelProcessing = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter(getParallelProcessingName()));
+    jassert(parallelProcessing != nullptr);
+
     auto intParams = std::array
     {
         &selectedTab
@@ -192,10 +351,88 @@ CAudioPluginAudioProcessor::CAudioPluginAudioProcessor()
     };
 
     initCachedParams<juce::AudioParameterInt*>(intParams, intFuncs);
+
+    for (auto* param : getParameters())
+    {
+        if (auto* paramWithID = dynamic_cast<juce::AudioProcessorParameterWithID*>(param))
+            apvts.addParameterListener(paramWithID->paramID, this);
+    }
+
+    publishParameterSnapshot();
+    blockParameters = &parameterSnapshots.acquire();
+
+    floatEngine.channelDSP.setProfiler(&profiler);
+    doubleEngine.channelDSP.setProfiler(&profiler);
+
+    telemetry.attachToSharedMemoryIfRequested();
+
+    startTimerHz(latencyPollRateHz);
 }
 
 CAudioPluginAudioProcessor::~CAudioPluginAudioProcessor()
 {
+    for (auto* param : getParameters())
+    {
+        if (auto* paramWithID = dynamic_cast<juce::AudioProcessorParameterWithID*>(param))
+            apvts.removeParameterListener(paramWithID->paramID, this);
+    }
+
+    stopTimer();
+}
+
+void CAudioPluginAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
+{
+    juce::ignoreUnused(parameterID, newValue);
+
+    /*
+        called on whichever thread changed the parameter, the audio thread included.
+        building the snapshot here would hold the channel's writer lock while the audio thread may want it.
+    */
+    parametersChanged.store(true, std::memory_order_release);
+}
+
+/*
+    the only place that reads the parameter atomics for the audio thread.
+    called by processBlock() when a parameter has changed, and while the audio thread isn't running.
+    so there is only ever one writer, and the channel's lock is never contended.
+*/
+void CAudioPluginAudioProcessor::publishParameterSnapshot()
+{
+    parameterSnapshots.publish([this](ParameterSnapshot& snapshot)
+    {
+        for (size_t i = 0; i < smoothedParams.size(); ++i)
+            snapshot.smoothedTargets[i] = smoothedParams[i]->get();
+
+        snapshot.ladderFilterModeIndex = ladderFilterMode->getIndex();
+        snapshot.generalFilterModeIndex = generalFilterMode->getIndex();
+        snapshot.overdriveOversamplingIndex = overdriveOversampling->getIndex();
+        snapshot.overdriveOversamplingFilterIndex = overdriveOversamplingFilter->getIndex();
+        snapshot.controlRateGranularityIndex = controlRateGranularity->getIndex();
+
+        snapshot.delaySync = delaySync->getIndex() == 1;
+        snapshot.delayNoteIndex = delayNote->getIndex();
+        snapshot.delayPingPong = delayMode->getIndex() == 1;
+        snapshot.delayInterpolationIndex = delayInterpolation->getIndex();
+
+        snapshot.bypassed = getBypassedStages();
+
+        snapshot.inputGainDb = inputGain->get();
+        snapshot.outputGainDb = outputGain->get();
+        snapshot.reorderCrossfadeMs = reorderCrossfadeMs->get();
+        snapshot.parallelProcessing = parallelProcessing->get();
+    });
+}
+
+DSP_Bypassed CAudioPluginAudioProcessor::getBypassedStages() const
+{
+    DSP_Bypassed bypassed{};
+    bypassed[static_cast<size_t>(DSP_Option::Phaser)] = phaserBypass->get();
+    bypassed[static_cast<size_t>(DSP_Option::Chorus)] = chorusBypass->get();
+    bypassed[static_cast<size_t>(DSP_Option::OverDrive)] = overdriveBypass->get();
+    bypassed[static_cast<size_t>(DSP_Option::LadderFilter)] = ladderFilterBypass->get();
+    bypassed[static_cast<size_t>(DSP_Option::GeneralFilter)] = generalFilterBypass->get();
+    bypassed[static_cast<size_t>(DSP_Option::Delay)] = delayBypass->get();
+    return bypassed;
 }
 
 //==============================================================================
@@ -233,7 +470,7 @@ bool CAudioPluginAudioProcessor::isMidiEffect() const
 
 double CAudioPluginAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return tailLengthSeconds.get();
 }
 
 int CAudioPluginAudioProcessor::getNumPrograms()
@@ -270,118 +507,234 @@ void CAudioPluginAudioProcessor::prepareToPlay (double sampleRate, int samplesPe
     spec.sampleRate = sampleRate;
     spec.maximumBlockSize = samplesPerBlock;
     
-    spec.numChannels = 1;
-    leftChannel.prepare(spec);
-    rightChannel.prepare(spec);
-
-    for (auto smoother : getSmoothers())
-    {
-        smoother->reset(sampleRate, 0.005);
-    }
+    spec.numChannels = static_cast<juce::uint32>(juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels()));
+    preparedSpec = spec;
+    publishParameterSnapshot();
+    blockParameters = &parameterSnapshots.acquire();
 
+    smoothers.reset(sampleRate, 0.005);
     updateSmoothersFromParams(1, SmootherUpdateMode::initialize);
 
-    spec.numChannels = getTotalNumInputChannels();
+    //hosts prepare again before every offline bounce, which is where parallel processing pays off.
+    offlineProfile = isNonRealtime();
 
-    inputGainDSP.prepare(spec);
-    outputGainDSP.prepare(spec);
+    /*
+        the pool is shared by every instance in the process, so turning it on offline doesn't start any threads
+        of this instance's own. the pool is let go of again once a realtime prepare no longer needs it.
+    */
+    const auto useWorkers = blockParameters->parallelProcessing || (offlineProfile && offlineWorkerPoolEnabled);
+    if (! useWorkers)
+        workerPool.reset();
+    else if (workerPool == nullptr)
+        workerPool = RealtimeWorkerPool::getShared();
+
+    //the host picks the precision before calling prepareToPlay, and can't change it without calling it again.
+    {
+        const juce::ScopedLock preparing(stagePreparationLock);
+
+        if (isUsingDoublePrecision())
+            prepareEngine(doubleEngine, spec);
+        else
+            prepareEngine(floatEngine, spec);
+    }
+
+    silenceDetector.prepare(sampleRate);
 
     leftSCSF.prepare(samplesPerBlock);
     rightSCSF.prepare(samplesPerBlock);
+    //only double blocks are converted, a float instance doesn't need the buffer
+    analyzerConversionBuffer.setSize(2, isUsingDoublePrecision() ? samplesPerBlock : 0);
+}
+
+template<typename SampleType>
+void CAudioPluginAudioProcessor::prepareEngine(ProcessingEngine<SampleType>& engine, const juce::dsp::ProcessSpec& spec)
+{
+    auto& channelDSP = engine.channelDSP;
+
+    /*
+        one channel group per thread.
+        realtime, the bypassed stages aren't prepared until timerCallback() sees them switched on,
+        and a stage coming back from a full bypass is reset there too.
+        offline there may be no message loop to do that, so every stage is prepared and resets in place.
+    */
+    const auto numWorkers = workerPool != nullptr ? workerPool->getNumWorkers() : 0;
+    channelDSP.setDefersStageResets(! offlineProfile);
+    channelDSP.prepare(spec, numWorkers + 1, offlineProfile ? DSP_Bypassed{} : blockParameters->bypassed, blockParameters->delayPingPong);
+    channelDSP.setFadeLengthSeconds(blockParameters->reorderCrossfadeMs * 0.001);
+
+    updateDSPFromParams(engine);
+    channelDSP.reset();
+
+    latencyInSamples.set(channelDSP.getLatencyInSamples(dspParameters));
+    setLatencySamples(latencyInSamples.get());
+
+    tailLengthSeconds.set(channelDSP.getTailLengthSeconds(dspParameters));
+
+    engine.inputGainDSP.setGainDecibels(blockParameters->inputGainDb);
+    engine.outputGainDSP.setGainDecibels(blockParameters->outputGainDb);
+    engine.inputGainDSP.prepare(spec);
+    engine.outputGainDSP.prepare(spec);
 }
 
 
 void CAudioPluginAudioProcessor::updateSmoothersFromParams(int numSamplesToSkip, SmootherUpdateMode init)
 {
-    auto paramsNeedingSmoothing = std::vector
-    {
-        phaserRateHz,
-        phaserCenterFreqHz,
-        phaserDepthPercent,
-        phaserFeedbackPercent,
-        phaserMixPercent,
-        chorusRateHz,
-        chorusDepthPercent,
-        chorusCenterDelayMs,
-        chorusFeedbackPercent,
-        chorusMixPercent,
-        overdriveSaturation,
-        ladderFilterCutoffHz,
-        ladderFilterResonance,
-        ladderFilterDrive,
-        generalFilterFreqHz,
-        generalFilterQuality,
-        generalFilterGain,
-        inputGain,
-        outputGain,
-    };
-
-    auto smoothers = getSmoothers();
-    jassert(smoothers.size() == paramsNeedingSmoothing.size());
+    /*
+        single pass over the binding table.
+        no containers are built here because this runs on the audio thread for every sub-block.
+    */
+    retargetSmoothersFromParams(init);
+    smoothers.skipAll(numSamplesToSkip);
+}
 
-    for (size_t i = 0; i < smoothers.size(); i++)
+void CAudioPluginAudioProcessor::retargetSmoothersFromParams(SmootherUpdateMode init)
+{
+    for (size_t i = 0; i < smoothedParams.size(); i++)
     {
-        auto smoother = smoothers[i];
-        auto param = paramsNeedingSmoothing[i];
+        auto value = blockParameters->smoothedTargets[i];
 
         if (init == SmootherUpdateMode::initialize)
-            smoother->setCurrentAndTargetValue(param->get());
+            smoothers.setCurrentAndTargetValue(i, value);
         else
-            smoother->setTargetValue(param->get());
+            smoothers.setTargetValue(i, value);
+    }
+}
 
-        smoother->skip(numSamplesToSkip);
+int CAudioPluginAudioProcessor::getControlRateGranularity() const
+{
+    return 8 << controlRateGranularity->getIndex();
+}
+
+template<typename SampleType>
+void CAudioPluginAudioProcessor::publishMeasurements(const MeteredGain<SampleType>& stage,
+                                                     juce::Atomic<float>& leftRMS, juce::Atomic<float>& rightRMS,
+                                                     juce::Atomic<float>& leftPeak, juce::Atomic<float>& rightPeak,
+                                                     juce::Atomic<float>& leftTruePeak, juce::Atomic<float>& rightTruePeak)
+{
+    //mono layouts show the same channel on both sides of the meter
+    const auto rightChannel = getTotalNumInputChannels() > 1 ? 1u : 0u;
+
+    auto left = stage.getMeasurement(0);
+    auto right = stage.getMeasurement(rightChannel);
+
+    leftRMS.set(static_cast<float>(left.rms));
+    rightRMS.set(static_cast<float>(right.rms));
+    leftPeak.set(static_cast<float>(left.peak));
+    rightPeak.set(static_cast<float>(right.peak));
+    leftTruePeak.set(static_cast<float>(left.truePeak));
+    rightTruePeak.set(static_cast<float>(right.truePeak));
+}
+
+void CAudioPluginAudioProcessor::updateAnalyzerFifos(const juce::AudioBuffer<float>& buffer)
+{
+    /*
+        the analyzer only shows the first two channels.
+        a mono buffer has no channel 1, so both fifos are fed channel 0.
+        analyzerBuffer only refers to the channels, nothing is copied or allocated.
+    */
+    if (buffer.getNumChannels() == 0)
+        return;
+
+    analyzerChannels[0] = const_cast<float*>(buffer.getReadPointer(0));
+    analyzerChannels[1] = const_cast<float*>(buffer.getReadPointer(buffer.getNumChannels() > 1 ? 1 : 0));
+    analyzerBuffer.setDataToReferTo(analyzerChannels.data(), static_cast<int>(analyzerChannels.size()), buffer.getNumSamples());
+
+    leftSCSF.update(analyzerBuffer);
+    rightSCSF.update(analyzerBuffer);
+}
+
+void CAudioPluginAudioProcessor::updateAnalyzerFifos(const juce::AudioBuffer<double>& buffer)
+{
+    const auto chunkSize = analyzerConversionBuffer.getNumSamples();
+    if (buffer.getNumChannels() == 0 || chunkSize == 0)
+        return;
+
+    const auto* left = buffer.getReadPointer(0);
+    const auto* right = buffer.getReadPointer(buffer.getNumChannels() > 1 ? 1 : 0);
+
+    for (int start = 0; start < buffer.getNumSamples(); start += chunkSize)
+    {
+        const auto numSamples = juce::jmin(chunkSize, buffer.getNumSamples() - start);
+
+        auto* leftOut = analyzerConversionBuffer.getWritePointer(0);
+        auto* rightOut = analyzerConversionBuffer.getWritePointer(1);
+        for (int i = 0; i < numSamples; ++i)
+        {
+            leftOut[i] = static_cast<float>(left[start + i]);
+            rightOut[i] = static_cast<float>(right[start + i]);
+        }
+
+        analyzerChannels[0] = leftOut;
+        analyzerChannels[1] = rightOut;
+        analyzerBuffer.setDataToReferTo(analyzerChannels.data(), static_cast<int>(analyzerChannels.size()), numSamples);
+
+        leftSCSF.update(analyzerBuffer);
+        rightSCSF.update(analyzerBuffer);
     }
 }
 
-std::vector<juce::SmoothedValue<float>*> CAudioPluginAudioProcessor::getSmoothers()
+bool CAudioPluginAudioProcessor::channelsNeedRegrouping() const
 {
-    auto smoothers = std::vector
+    const auto pingPong = delayMode->getIndex() == 1;
+
+    return isUsingDoublePrecision() ? ! doubleEngine.channelDSP.isGroupedFor(pingPong)
+                                    : ! floatEngine.channelDSP.isGroupedFor(pingPong);
+}
+
+void CAudioPluginAudioProcessor::regroupChannels()
+{
+    //suspendProcessing() waits for a running processBlock to return, and the host outputs silence until it's resumed.
+    suspendProcessing(true);
     {
-        &phaserRateHzSmoother,
-        &phaserCenterFreqHzSmoother,
-        &phaserDepthPercentSmoother,
-        &phaserFeedbackPercentSmoother,
-        &phaserMixPercentSmoother,
-        &chorusRateHzSmoother,
-        &chorusDepthPercentSmoother,
-        &chorusCenterDelayMsSmoother,
-        &chorusFeedbackPercentSmoother,
-        &chorusMixPercentSmoother,
-        &overdriveSaturationSmoother,
-        &ladderFilterCutoffHzSmoother,
-        &ladderFilterResonanceSmoother,
-        &ladderFilterDriveSmoother,
-        &generalFilterFreqHzSmoother,
-        &generalFilterQualitySmoother,
-        &generalFilterGainSmoother,
-        &inputGainSmoother,
-        &outputGainSmoother,
-    };
+        const juce::ScopedLock preparing(stagePreparationLock);
+
+        //the audio thread isn't running, so the snapshot can be taken here like prepareToPlay does.
+        publishParameterSnapshot();
+        blockParameters = &parameterSnapshots.acquire();
 
-    return smoothers;
+        if (isUsingDoublePrecision())
+            prepareEngine(doubleEngine, preparedSpec);
+        else
+            prepareEngine(floatEngine, preparedSpec);
+    }
+    suspendProcessing(false);
 }
 
-void CAudioPluginAudioProcessor::MonoChannelDSP::prepare(const juce::dsp::ProcessSpec& spec)
-{   
-    jassert(spec.numChannels == 1);
-    std::vector<juce::dsp::ProcessorBase*> dsp{
-    &phaser,
-    &chorus,
-    &overdrive,
-    &ladderFilter,
-    &generalFilter,
-    };
+void CAudioPluginAudioProcessor::timerCallback()
+{
+    /*
+        switching the delay's ping-pong while the channels run in groups that split its pairs regroups them.
+        offline there may be no message loop, the next prepareToPlay picks the grouping up instead.
+    */
+    if (! offlineProfile && preparedSpec.sampleRate > 0.0 && channelsNeedRegrouping())
+        regroupChannels();
 
-    for (auto p : dsp) {
-        p->prepare(spec);
-        p->reset();
+    /*
+        prepareToPlay only prepares the stages that are switched on.
+        one that has been switched on since is prepared here, and the audio thread fades it in once it's ready.
+        the same goes for a stage the audio thread handed back to be reset.
+    */
+    const juce::ScopedTryLock preparing(stagePreparationLock);
+    if (preparing.isLocked())
+    {
+        const auto bypassed = getBypassedStages();
+        if (isUsingDoublePrecision())
+            doubleEngine.channelDSP.prepareSkippedStages(bypassed);
+        else
+            floatEngine.channelDSP.prepareSkippedStages(bypassed);
     }
+
+    const auto latency = latencyInSamples.get();
+    if (latency != getLatencySamples())
+        setLatencySamples(latency);
 }
 
 void CAudioPluginAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    //the shared pool stops once no instance holds on to it.
+    workerPool.reset();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -391,12 +744,12 @@ bool CAudioPluginAudioProcessor::isBusesLayoutSupported (const BusesLayout& layo
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    /*
+        the chain runs any channel count (see SIMDChannelPacker), so any layout up to maxNumChannels is fine.
+        that covers mono, stereo, 5.1, 7.1.4 and ambisonics up to 3rd order (16 channels).
+    */
+    const auto& outputSet = layouts.getMainOutputChannelSet();
+    if (outputSet.isDisabled() || outputSet.size() > maxNumChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -554,8 +907,9 @@ juce::AudioProcessorValueTreeState::ParameterLayout CAudioPluginAudioProcessor::
 
     /*
     Overdrive:
-        Uses the drive portion of the ladder filter class for now
         drive: 1-100
+        oversampling: 1x, 2x, 4x, 8x
+        oversampling filter: polyphase IIR, FIR
     */
     //drive: 1-100
     name = getOverdriveSaturationName();
@@ -566,6 +920,14 @@ juce::AudioProcessorValueTreeState::ParameterLayout CAudioPluginAudioProcessor::
         1.f,
         ""));
 
+    name = getOverdriveOversamplingName();
+    auto choices = getOverdriveOversamplingChoices();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{ name, versionHint }, name, choices, static_cast<int>(OverdriveOversampling::x2)));
+
+    name = getOverdriveOversamplingFilterName();
+    choices = getOverdriveOversamplingFilterChoices();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{ name, versionHint }, name, choices, static_cast<int>(OverdriveFilterType::PolyphaseIIR)));
+
     name = getOverdriveBypassName();
     layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{ name, versionHint }, name, false));
 
@@ -578,7 +940,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout CAudioPluginAudioProcessor::
     */
 
     name = getLadderFilterModeName();
-    auto choices = getLadderFilterChoices();
+    choices = getLadderFilterChoices();
     layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{ name, versionHint }, name, choices, 0 ));
 
     name = getLadderFilterCutoffName();
@@ -651,6 +1013,113 @@ juce::AudioProcessorValueTreeState::ParameterLayout CAudioPluginAudioProcessor::
     name = getGeneralFilterBypassName();
     layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{ name, versionHint }, name, false));
 
+    /*
+        delay:
+        time: 1 - 2000ms, or a note length at the host tempo
+        feedback: 0 - 95%, low cut 20 - 2000Hz, high cut 200 - 20000Hz
+        modulation: 0.01 - 10Hz, 0 - 10ms
+        sync, mode and interpolation are choices rather than bools, so the DSP_Gui shows them.
+        the delay starts bypassed, so sessions saved before it existed sound the same.
+    */
+    name = getDelayTimeName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name, versionHint },
+        name,
+        juce::NormalisableRange<float>(1.f, 2000.f, 0.1f, 0.4f),
+        250.f,
+        "ms"));
+
+    name = getDelaySyncName();
+    choices = getDelaySyncChoices();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{ name, versionHint }, name, choices, 0));
+
+    name = getDelayNoteName();
+    choices = getDelayNoteChoices();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{ name, versionHint }, name, choices, choices.indexOf("1/8")));
+
+    name = getDelayFeedbackName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name, versionHint },
+        name,
+        juce::NormalisableRange<float>(0.f, 95.f, 0.1f, 1.f),
+        35.f,
+        "%"));
+
+    name = getDelayLowCutName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name, versionHint },
+        name,
+        juce::NormalisableRange<float>(20.f, 2000.f, 1.f, 0.4f),
+        80.f,
+        "Hz"));
+
+    name = getDelayHighCutName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name, versionHint },
+        name,
+        juce::NormalisableRange<float>(200.f, 20000.f, 1.f, 0.4f),
+        8000.f,
+        "Hz"));
+
+    name = getDelayModulationRateName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name, versionHint },
+        name,
+        juce::NormalisableRange<float>(0.01f, 10.f, 0.01f, 1.f),
+        0.5f,
+        "Hz"));
+
+    name = getDelayModulationDepthName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name, versionHint },
+        name,
+        juce::NormalisableRange<float>(0.f, 10.f, 0.01f, 1.f),
+        1.f,
+        "ms"));
+
+    name = getDelayMixName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name, versionHint },
+        name,
+        juce::NormalisableRange<float>(0.0f, 100.f, 0.1f, 1.f),
+        25.f,
+        "%"));
+
+    name = getDelayModeName();
+    choices = getDelayModeChoices();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{ name, versionHint }, name, choices, 0));
+
+    name = getDelayInterpolationName();
+    choices = getDelayInterpolationChoices();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{ name, versionHint }, name, choices, static_cast<int>(DelayInterpolation::Lagrange3rd)));
+
+    name = getDelayBypassName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{ name, versionHint }, name, true));
+
+    /*
+        sub-block size used while parameters are being automated.
+        smaller reacts faster, larger costs less.
+    */
+    name = getControlRateGranularityName();
+    choices = getControlRateGranularityChoices();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{ name, versionHint }, name, choices, 3));
+
+    //reorder crossfade: 5 - 250ms
+    name = getReorderCrossfadeName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name, versionHint },
+        name,
+        juce::NormalisableRange<float>(5.f, 250.f, 1.f, 1.f),
+        static_cast<float>(CrossfadingChain<float>::defaultFadeLengthSeconds * 1000.0),
+        "ms"));
+
+    /*
+        splits the channels into groups that run on worker threads when the host hands over large blocks.
+        the output is identical either way.
+    */
+    name = getParallelProcessingName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{ name, versionHint }, name, false));
+
     name = getSelectedTabName();
     layout.add(std::make_unique<juce::AudioParameterInt>(juce::ParameterID{ name, versionHint },
         name,
@@ -661,93 +1130,60 @@ juce::AudioProcessorValueTreeState::ParameterLayout CAudioPluginAudioProcessor::
     return layout;
 }
 
-void CAudioPluginAudioProcessor::MonoChannelDSP::updateDSPFromParams()
+template<typename SampleType>
+void CAudioPluginAudioProcessor::updateDSPFromParams(ProcessingEngine<SampleType>& engine)
 {
-    phaser.dsp.setRate( p.phaserRateHzSmoother.getCurrentValue() );
-    phaser.dsp.setCentreFrequency( p.phaserCenterFreqHzSmoother.getCurrentValue() );
-    phaser.dsp.setDepth( p.phaserDepthPercentSmoother.getCurrentValue() * 0.01f);
-    phaser.dsp.setFeedback( p.phaserFeedbackPercentSmoother.getCurrentValue() * 0.01f);
-    phaser.dsp.setMix( p.phaserMixPercentSmoother.getCurrentValue() * 0.01f);
-
-    chorus.dsp.setRate( p.chorusRateHzSmoother.getCurrentValue());
-    chorus.dsp.setDepth( p.chorusDepthPercentSmoother.getCurrentValue() * 0.01f);
-    chorus.dsp.setCentreDelay( p.chorusCenterDelayMsSmoother.getCurrentValue());
-    chorus.dsp.setFeedback( p.chorusFeedbackPercentSmoother.getCurrentValue() * 0.01f);
-    chorus.dsp.setMix( p.chorusMixPercentSmoother.getCurrentValue() * 0.01f);
-
-    overdrive.dsp.setDrive( p.overdriveSaturationSmoother.getCurrentValue());
-
-    ladderFilter.dsp.setMode( static_cast<juce::dsp::LadderFilterMode>(p.ladderFilterMode->getIndex()) );
-    ladderFilter.dsp.setCutoffFrequencyHz( p.ladderFilterCutoffHzSmoother.getCurrentValue());
-    ladderFilter.dsp.setResonance( p.ladderFilterResonanceSmoother.getCurrentValue() * 0.01f);
-    ladderFilter.dsp.setDrive( p.ladderFilterDriveSmoother.getCurrentValue());
-
-    //TODO: update general filter coefficients here
-    auto sampleRate = p.getSampleRate();
-    //update generalFilter coefficients
-    //choices: peak, bandpass, notch, allpass
-    auto genMode = p.generalFilterMode->getIndex();
-    auto genHz = p.generalFilterFreqHzSmoother.getCurrentValue();
-    auto genQ = p.generalFilterQualitySmoother.getCurrentValue();
-    auto genGain = p.generalFilterGainSmoother.getCurrentValue();
-
-    bool filterChanged = false;
-    filterChanged |= (filterFreq != genHz);
-    filterChanged |= (filterQ != genQ);
-    filterChanged |= (filterGain != genGain);
-
-    auto updatedMode = static_cast<GeneralFilterMode>(genMode);
-    filterChanged |= (filterMode != updatedMode);
-
-    if (filterChanged)
+    StageProfiler::ScopedTimer timer(&profiler, ProfiledSection::CoefficientUpdate);
+    auto& params = dspParameters;
+
+    params.phaserRateHz = smoothers.getCurrentValue(PhaserRateHz);
+    params.phaserCenterFreqHz = smoothers.getCurrentValue(PhaserCenterFreqHz);
+    params.phaserDepthPercent = smoothers.getCurrentValue(PhaserDepthPercent);
+    params.phaserFeedbackPercent = smoothers.getCurrentValue(PhaserFeedbackPercent);
+    params.phaserMixPercent = smoothers.getCurrentValue(PhaserMixPercent);
+
+    params.chorusRateHz = smoothers.getCurrentValue(ChorusRateHz);
+    params.chorusDepthPercent = smoothers.getCurrentValue(ChorusDepthPercent);
+    params.chorusCenterDelayMs = smoothers.getCurrentValue(ChorusCenterDelayMs);
+    params.chorusFeedbackPercent = smoothers.getCurrentValue(ChorusFeedbackPercent);
+    params.chorusMixPercent = smoothers.getCurrentValue(ChorusMixPercent);
+
+    params.overdriveSaturation = smoothers.getCurrentValue(OverdriveSaturation);
+    params.overdriveOversampling = static_cast<OverdriveOversampling>(blockParameters->overdriveOversamplingIndex);
+    params.overdriveFilterType = static_cast<OverdriveFilterType>(blockParameters->overdriveOversamplingFilterIndex);
+
+    //latency doesn't matter offline, so the overdrive gets the most oversampling and the linear phase filters.
+    if (offlineProfile)
     {
-        filterMode = updatedMode;
-        filterFreq = genHz;
-        filterQ = genQ;
-        filterGain = genGain;
-
-        juce::dsp::IIR::Coefficients<float>::Ptr coefficients;
-
-        switch (filterMode)
-        {
-            case GeneralFilterMode::Peak:
-            {
-                coefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, filterFreq, filterQ, juce::Decibels::decibelsToGain(filterGain));
-                break;
-            }
-            case GeneralFilterMode::Bandpass:
-            {
-                coefficients = juce::dsp::IIR::Coefficients<float>::makeBandPass(sampleRate, filterFreq, filterQ);
-                break;
-            }
-            case GeneralFilterMode::Notch:
-            {
-                coefficients = juce::dsp::IIR::Coefficients<float>::makeNotch(sampleRate, filterFreq, filterQ);
-                break;
-            }
-            case GeneralFilterMode::Allpass:
-            {
-                coefficients = juce::dsp::IIR::Coefficients<float>::makeAllPass(sampleRate, filterFreq, filterQ);
-                break;
-            }
-            case GeneralFilterMode::END_OF_LIST:
-            {
-                jassertfalse;
-                break;
-            }
-        }
-
-        if (coefficients != nullptr)
-        {
-            //if (generalFilter.dsp.coefficients->coefficients.size() != coefficients->coefficients.size())
-            //{
-            //    jassertfalse;
-            //}
-
-            *generalFilter.dsp.coefficients = *coefficients;
-            generalFilter.reset();
-        }
+        params.overdriveOversampling = OverdriveOversampling::x8;
+        params.overdriveFilterType = OverdriveFilterType::FIR;
     }
+
+    params.ladderFilterMode = static_cast<juce::dsp::LadderFilterMode>(blockParameters->ladderFilterModeIndex);
+    params.ladderFilterCutoffHz = smoothers.getCurrentValue(LadderFilterCutoffHz);
+    params.ladderFilterResonancePercent = smoothers.getCurrentValue(LadderFilterResonance);
+    params.ladderFilterDrive = smoothers.getCurrentValue(LadderFilterDrive);
+
+    params.generalFilterMode = static_cast<GeneralFilterMode>(blockParameters->generalFilterModeIndex);
+    params.generalFilterFreqHz = smoothers.getCurrentValue(GeneralFilterFreqHz);
+    params.generalFilterQuality = smoothers.getCurrentValue(GeneralFilterQuality);
+    params.generalFilterGainDb = smoothers.getCurrentValue(GeneralFilterGain);
+
+    params.delayTimeMs = blockParameters->delaySync
+                       ? static_cast<float>(60000.0 / hostBpm * getDelayNoteLengthInBeats(blockParameters->delayNoteIndex))
+                       : smoothers.getCurrentValue(DelayTimeMs);
+    params.delayFeedbackPercent = smoothers.getCurrentValue(DelayFeedbackPercent);
+    params.delayLowCutHz = smoothers.getCurrentValue(DelayLowCutHz);
+    params.delayHighCutHz = smoothers.getCurrentValue(DelayHighCutHz);
+    params.delayModulationRateHz = smoothers.getCurrentValue(DelayModulationRateHz);
+    params.delayModulationDepthMs = smoothers.getCurrentValue(DelayModulationDepthMs);
+    params.delayMixPercent = smoothers.getCurrentValue(DelayMixPercent);
+    params.delayPingPong = blockParameters->delayPingPong;
+    params.delayInterpolation = static_cast<DelayInterpolation>(blockParameters->delayInterpolationIndex);
+
+    params.bypassed = blockParameters->bypassed;
+
+    engine.channelDSP.updateDSPFromParams(params);
 }
 
 std::vector<juce::RangedAudioParameter*> CAudioPluginAudioProcessor::getParamsForOption(DSP_Option option)
@@ -783,6 +1219,8 @@ std::vector<juce::RangedAudioParameter*> CAudioPluginAudioProcessor::getParamsFo
             return
             {
                 overdriveSaturation,
+                overdriveOversampling,
+                overdriveOversamplingFilter,
                 overdriveBypass,
             };
         }
@@ -808,6 +1246,24 @@ std::vector<juce::RangedAudioParameter*> CAudioPluginAudioProcessor::getParamsFo
                 generalFilterBypass,
             };
         }
+        case CAudioPluginAudioProcessor::DSP_Option::Delay:
+        {
+            return
+            {
+                delayTimeMs,
+                delaySync,
+                delayNote,
+                delayFeedbackPercent,
+                delayLowCutHz,
+                delayHighCutHz,
+                delayModulationRateHz,
+                delayModulationDepthMs,
+                delayMixPercent,
+                delayMode,
+                delayInterpolation,
+                delayBypass,
+            };
+        }
         case CAudioPluginAudioProcessor::DSP_Option::END_OF_LIST:
         {
             break;
@@ -818,8 +1274,38 @@ std::vector<juce::RangedAudioParameter*> CAudioPluginAudioProcessor::getParamsFo
 };
 
 void CAudioPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    jassert(! isUsingDoublePrecision());
+    processBlockWithEngine(buffer, floatEngine);
+}
+
+void CAudioPluginAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    jassert(isUsingDoublePrecision());
+    processBlockWithEngine(buffer, doubleEngine);
+}
+
+bool CAudioPluginAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template<typename SampleType>
+void CAudioPluginAudioProcessor::processBlockWithEngine(juce::AudioBuffer<SampleType>& buffer, ProcessingEngine<SampleType>& engine)
 {
     juce::ScopedNoDenormals noDenormals;
+    DeadlineTelemetry::ScopedBlock<SampleType> blockTelemetry(telemetry, buffer, getSampleRate());
+    AllocationTracker::ScopedRealtimeSection realtimeSection;
+    StageProfiler::ScopedTimer blockTimer(&profiler, ProfiledSection::ProcessBlock);
+
+    //the parameters as they were when this block started. everything below reads them from here.
+    if (parametersChanged.exchange(false, std::memory_order_acquire))
+        publishParameterSnapshot();
+
+    blockParameters = &parameterSnapshots.acquire();
+
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -869,12 +1355,21 @@ void CAudioPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     //TODO: wet/dry know [BONUS]
     //TODO: mono & stereo versions [mono is BONUS]
     //TODO: modulators [BONUS]
-    //TODO: thread-safe filter updating [BONUS]
+    //DONE: thread-safe filter updating [BONUS]
     //TODO: pre/post filtering [BONUS]
-    //TODO: delay module [BONUS]
+    //DONE: delay module [BONUS]
+
+    auto& channelDSP = engine.channelDSP;
+    auto& inputGainDSP = engine.inputGainDSP;
+    auto& outputGainDSP = engine.outputGainDSP;
+
+    //the synced delay time follows the host tempo. a host that doesn't report one keeps the last tempo seen.
+    if (auto* playHead = getPlayHead())
+        if (auto position = playHead->getPosition())
+            if (auto bpm = position->getBpm(); bpm.hasValue() && *bpm > 0.0)
+                hostBpm = *bpm;
 
-    leftChannel.updateDSPFromParams();
-    rightChannel.updateDSPFromParams();
+    updateDSPFromParams(engine);
 
     // default instance
     auto newDSPOrder = DSP_Order();
@@ -887,6 +1382,8 @@ void CAudioPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     }
 
     // if you pulled, replace dspOrder;
+    // channelDSP crossfades from the old order to the new one.
+    channelDSP.setFadeLengthSeconds(blockParameters->reorderCrossfadeMs * 0.001);
     if (newDSPOrder != DSP_Order()) {
         dspOrder = newDSPOrder;
     }
@@ -900,124 +1397,94 @@ void CAudioPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
         restoreDspOrderFifo.push(dspOrder);
     }
 
-    //auto block = juce::dsp::AudioBlock<float>(buffer);
-    //leftChannel.process(block.getSingleChannelBlock(0), dspOrder);
-    //rightChannel.process(block.getSingleChannelBlock(1), dspOrder);
+    auto block = juce::dsp::AudioBlock<SampleType>(buffer);
 
-    auto block = juce::dsp::AudioBlock<float>(buffer);
-    auto preCtx = juce::dsp::ProcessContextReplacing<float>(block);
-
-    inputGainSmoother.setTargetValue(inputGain->get());
-    outputGainSmoother.setTargetValue(outputGain->get());
-    inputGainDSP.setGainDecibels(inputGainSmoother.getNextValue());
-    inputGainDSP.process(preCtx);
+    /*
+        the in/out gain stages ramp per sample on their own,
+        and run on each sub-block right before/after the chain while it is still in cache.
+    */
+    inputGainDSP.setGainDecibels(blockParameters->inputGainDb);
+    outputGainDSP.setGainDecibels(blockParameters->outputGainDb);
+    inputGainDSP.startMeasurement();
+    outputGainDSP.startMeasurement();
 
     /*
-        process max 64 samples at a time.
+        control-rate scheduler:
+        while any smoother is moving, process at most 'granularity' samples at a time so the DSP follows the automation.
+        once everything has settled, the rest of the block is processed in one go.
     */
     const auto numSamples = buffer.getNumSamples(); // (1)
     auto samplesRemaining = numSamples;
-    auto maxSamplesToProcess = juce::jmin(samplesRemaining, 64); // (2)
 
-    leftPreRMS.set(buffer.getRMSLevel(0, 0, numSamples));
-    rightPreRMS.set(buffer.getRMSLevel(1, 0, numSamples));
-    
- 
+    /*
+        once the input has been silent for longer than the chain's tail, the chain is skipped.
+        the gain stages keep running, so the meters and gain ramps carry on.
+        the input gain's peak meter decides, so the buffer isn't scanned an extra time.
+    */
+    const auto tail = channelDSP.getTailLengthSeconds(dspParameters);
+    tailLengthSeconds.set(tail);
+
+    //offline, the whole block is one sub-block and the smoothers move once per block.
+    auto maxSamplesToProcess = offlineProfile ? numSamples : 8 << blockParameters->controlRateGranularityIndex; // (2)
+    auto smallestSubBlock = numSamples;
+
     size_t startSample = 0; // (10)
     while (samplesRemaining > 0) // (3)
     {
         /*
             figure out how many samples to actually process.
-            i.e., you might have a buffer size of 72.
+            i.e., you might have a buffer size of 72 while a parameter is moving.
             The first time through this loop samplesToProcess will be 64, because maxSamplesToProcess is set to 64, and samplesRemaing is 72.
             The second time this loop runs, samplesToProcess will be 8, because the previous loop consumed 64 of the 72 samples.
+            If nothing is moving, samplesToProcess is all 72 samples.
         */
-        auto samplesToProcess = juce::jmin(samplesRemaining, maxSamplesToProcess); // (4)
+        const auto smootherStart = blockTimer.profiler != nullptr ? StageProfiler::now() : 0;
+
+        retargetSmoothersFromParams(SmootherUpdateMode::liveInRealtime);
+        auto samplesToProcess = smoothers.isAnySmoothing() ? juce::jmin(samplesRemaining, maxSamplesToProcess)
+                                                           : samplesRemaining; // (4)
+        smallestSubBlock = juce::jmin(smallestSubBlock, samplesToProcess);
+
         //advance each smoother 'samplesToProcess' samples
-        updateSmoothersFromParams(samplesToProcess, SmootherUpdateMode::liveInRealtime); // (5)
+        smoothers.skipAll(samplesToProcess); // (5)
+
+        if (blockTimer.profiler != nullptr)
+            blockTimer.profiler->record(ProfiledSection::SmootherUpdate, smootherStart, StageProfiler::now());
 
         //update the DSP
-        leftChannel.updateDSPFromParams(); // (6)
-        rightChannel.updateDSPFromParams();
+        updateDSPFromParams(engine); // (6)
 
         //create a sub block from the buffer, and
         auto subBlock = block.getSubBlock(startSample, samplesToProcess); // (7)
 
-        //now process
-        leftChannel.process(subBlock.getSingleChannelBlock(0), dspOrder); // (8)
-        rightChannel.process(subBlock.getSingleChannelBlock(1), dspOrder);
+        //now process all channels together
+        auto subCtx = juce::dsp::ProcessContextReplacing<SampleType>(subBlock);
+        inputGainDSP.process(subCtx);
+
+        const auto inputIsSilent = SilenceDetector::isSilent(inputGainDSP, subBlock.getNumChannels());
+        if (! silenceDetector.update(inputIsSilent, samplesToProcess, tail))
+            channelDSP.process(subBlock, dspOrder, dspParameters, workerPool.get()); // (8)
+        outputGainDSP.process(subCtx);
 
         startSample += samplesToProcess; // (9)
         samplesRemaining -= samplesToProcess;
     }
 
-    auto postCtx = juce::dsp::ProcessContextReplacing<float>(block);
-    outputGainDSP.setGainDecibels(outputGainSmoother.getNextValue());
-    outputGainDSP.process(postCtx);
-
-    leftPostRMS.set(buffer.getRMSLevel(0, 0, numSamples));
-    rightPostRMS.set(buffer.getRMSLevel(1, 0, numSamples));
-
-    leftSCSF.update(buffer);
-    rightSCSF.update(buffer);
-}
-
-void CAudioPluginAudioProcessor::MonoChannelDSP::process(juce::dsp::AudioBlock<float> block, const DSP_Order &dspOrder)
-{
-    DSP_Pointers dspPointers;
-    dspPointers.fill({}); // this was previously dspPointers.fill(nullptr);
-
-    for (size_t i = 0; i < dspPointers.size(); i++)
-    {
-        switch (dspOrder[i]) {
-        case DSP_Option::Phaser:
-            dspPointers[i].processor = &phaser;
-            dspPointers[i].bypassed = p.phaserBypass->get();
-            break;
-        case DSP_Option::Chorus:
-            dspPointers[i].processor = &chorus;
-            dspPointers[i].bypassed = p.chorusBypass->get();
-            break;
-        case DSP_Option::OverDrive:
-            dspPointers[i].processor = &overdrive;
-            dspPointers[i].bypassed = p.overdriveBypass->get();
-            break;
-        case DSP_Option::LadderFilter:
-            dspPointers[i].processor = &ladderFilter;
-            dspPointers[i].bypassed = p.ladderFilterBypass->get();
-            break;
-        case DSP_Option::GeneralFilter:
-            dspPointers[i].processor = &generalFilter;
-            dspPointers[i].bypassed = p.generalFilterBypass->get();
-            break;
-        case DSP_Option::END_OF_LIST:
-            jassertfalse;
-            break;
-        }
-    }
+    currentSubBlockSize.set(smallestSubBlock);
+    profiler.addProcessedSamples(numSamples, getSampleRate());
 
-    // now process
-    auto context = juce::dsp::ProcessContextReplacing<float>(block);
+    //both gain stages metered the buffer while they applied their gain.
+    publishMeasurements(inputGainDSP, leftPreRMS, rightPreRMS, leftPrePeak, rightPrePeak, leftPreTruePeak, rightPreTruePeak);
+    publishMeasurements(outputGainDSP, leftPostRMS, rightPostRMS, leftPostPeak, rightPostPeak, leftPostTruePeak, rightPostTruePeak);
 
-    for (size_t i = 0; i < dspPointers.size(); ++i)
-    {
-        if (dspPointers[i].processor != nullptr)
-        {
-            juce::ScopedValueSetter<bool> svs(context.isBypassed, dspPointers[i].bypassed);
-#if VERIFY_BYPASS_FUNCTIONALITY
-            if (context.isBypassed)
-            {
-                jassertfalse;
-            }
+    updateAnalyzerFifos(buffer);
 
-            if (dspPointers[i].processor == &generalFilter)
-            {
-                continue;
-            }
-#endif
-            dspPointers[i].processor->process(context);
-        }
-    }
+    /*
+        changing the oversampling changes the latency.
+        the host can't be told from the audio thread, and neither can the message thread be woken from it:
+        posting a message takes a lock and writes to a pipe. timerCallback() picks it up instead.
+    */
+    latencyInSamples.set(channelDSP.getLatencyInSamples(dspParameters));
 }
 
 //==============================================================================
@@ -1055,10 +1522,25 @@ struct juce::VariantConverter<CAudioPluginAudioProcessor::DSP_Order>
             {
                 arr.push_back(mis.readInt());
             }
-            jassert(arr.size() == dspOrder.size());
+
+            /*
+                sessions saved before a stage was added have a shorter order.
+                the stages they know keep their positions, the new ones go at the end.
+            */
+            std::array<bool, std::tuple_size_v<T>> restored{};
+            size_t numRestored = 0;
+            for (auto value : arr)
+            {
+                if (juce::isPositiveAndBelow(value, static_cast<int>(dspOrder.size())) && ! restored[static_cast<size_t>(value)] && numRestored < dspOrder.size())
+                {
+                    dspOrder[numRestored++] = static_cast<CAudioPluginAudioProcessor::DSP_Option>(value);
+                    restored[static_cast<size_t>(value)] = true;
+                }
+            }
             for (size_t i = 0; i < dspOrder.size(); i++)
             {
-                dspOrder[i] = static_cast<CAudioPluginAudioProcessor::DSP_Option>(arr[i]);
+                if (! restored[i])
+                    dspOrder[numRestored++] = static_cast<CAudioPluginAudioProcessor::DSP_Option>(i);
             }
         }
         return dspOrder;
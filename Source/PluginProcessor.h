@@ -11,24 +11,25 @@
 #include <JuceHeader.h>
 #include <Fifo.h>
 #include <SingleChannelSampleFifo.h>
+#include "DSP/SmootherBank.h"
+#include "DSP/MultiChannelDSP.h"
+#include "DSP/ParallelChain.h"
+#include "DSP/MeteredGain.h"
+#include "DSP/SilenceDetector.h"
+#include "DSP/SnapshotChannel.h"
+#include "Diagnostics/StageProfiler.h"
+#include "Diagnostics/DeadlineTelemetry.h"
 
 
 static constexpr int NEGATIVE_INFINITY = -72;
 static constexpr int MAX_DECIBELS = 12;
 
-enum class GeneralFilterMode
-{
-    Peak,
-    Bandpass,
-    Notch,
-    Allpass,
-    END_OF_LIST
-};
-
 //==============================================================================
 /**
 */
-class CAudioPluginAudioProcessor  : public juce::AudioProcessor
+class CAudioPluginAudioProcessor  : public juce::AudioProcessor,
+                                    private juce::Timer,
+                                    private juce::AudioProcessorValueTreeState::Listener
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
@@ -47,6 +48,8 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -71,24 +74,14 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
-    //strongly typed enumeration (scoped enumeration)
-    enum class DSP_Option
-    {
-        Phaser,
-        Chorus,
-        OverDrive,
-        LadderFilter,
-        GeneralFilter,
-        END_OF_LIST
-    };
+    using DSP_Option = ::DSP_Option;
 
     //static function
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     //declare an instance
     juce::AudioProcessorValueTreeState apvts{ *this, nullptr, "Settings", createParameterLayout() };
 
-    //array alias
-    using DSP_Order = std::array < DSP_Option, static_cast<size_t>(DSP_Option::END_OF_LIST)>;
+    using DSP_Order = ::DSP_Order;
 
     //FIFO Instance
     SimpleMBComp::Fifo<DSP_Order> dspOrderFifo, restoreDspOrderFifo;
@@ -118,6 +111,8 @@ public:
     juce::AudioParameterBool* chorusBypass = nullptr;
 
     juce::AudioParameterFloat* overdriveSaturation = nullptr;
+    juce::AudioParameterChoice* overdriveOversampling = nullptr;
+    juce::AudioParameterChoice* overdriveOversamplingFilter = nullptr;
     juce::AudioParameterBool* overdriveBypass = nullptr;
 
     juce::AudioParameterChoice* ladderFilterMode = nullptr;
@@ -132,97 +127,241 @@ public:
     juce::AudioParameterFloat* generalFilterGain = nullptr;
     juce::AudioParameterBool* generalFilterBypass= nullptr;
 
+    /*
+        Delay:
+            Time: ms, or a note length when synced to the host tempo
+            Feedback: 0 to 95%, through a low cut and a high cut
+            Modulation: rate in Hz, depth in ms
+            Mode: stereo or ping-pong
+    */
+    juce::AudioParameterFloat* delayTimeMs = nullptr;
+    juce::AudioParameterChoice* delaySync = nullptr;
+    juce::AudioParameterChoice* delayNote = nullptr;
+    juce::AudioParameterFloat* delayFeedbackPercent = nullptr;
+    juce::AudioParameterFloat* delayLowCutHz = nullptr;
+    juce::AudioParameterFloat* delayHighCutHz = nullptr;
+    juce::AudioParameterFloat* delayModulationRateHz = nullptr;
+    juce::AudioParameterFloat* delayModulationDepthMs = nullptr;
+    juce::AudioParameterFloat* delayMixPercent = nullptr;
+    juce::AudioParameterChoice* delayMode = nullptr;
+    juce::AudioParameterChoice* delayInterpolation = nullptr;
+    juce::AudioParameterBool* delayBypass = nullptr;
+
     juce::AudioParameterInt* selectedTab = nullptr;
 
+    //largest sub-block the control-rate scheduler uses while parameters are moving: 8, 16, 32 or 64 samples
+    juce::AudioParameterChoice* controlRateGranularity = nullptr;
+    int getControlRateGranularity() const;
+
+    //how long the old and new DSP_Order run side by side after a reorder
+    juce::AudioParameterFloat* reorderCrossfadeMs = nullptr;
+
+    //spread channel groups over workerPool. picked up by the next prepareToPlay.
+    juce::AudioParameterBool* parallelProcessing = nullptr;
+
+    /*
+        the offline profile borrows the process-wide worker pool on its own, so a bounce with many instances
+        still only has one set of workers, and they take turns on it.
+        a host that already runs one instance per core (e.g. the batch processor) turns that off. picked up by the next prepareToPlay.
+    */
+    void setOfflineWorkerPoolEnabled(bool shouldBeEnabled) noexcept { offlineWorkerPoolEnabled = shouldBeEnabled; }
+
+    //the smallest sub-block the scheduler used in the last processBlock. the whole block when nothing was moving.
+    juce::Atomic<int> currentSubBlockSize{ 0 };
+
+    //per-stage timings of this instance, off until the editor's profiler overlay turns it on.
+    StageProfiler profiler;
+
+    /*
+        deadline misses, the longest block, denormal flushes and non-finite output, always on.
+        published in the shared telemetry segment when DeadlineTelemetry::sharedMemoryEnvironmentVariable is set.
+    */
+    DeadlineTelemetry telemetry{ profiler.getInstanceId() };
+
     juce::AudioParameterFloat* inputGain = nullptr;
     juce::AudioParameterFloat* outputGain = nullptr;
 
-    juce::SmoothedValue<float>
-        phaserRateHzSmoother,
-        phaserCenterFreqHzSmoother,
-        phaserDepthPercentSmoother,
-        phaserFeedbackPercentSmoother,
-        phaserMixPercentSmoother,
-        chorusRateHzSmoother,
-        chorusDepthPercentSmoother,
-        chorusCenterDelayMsSmoother,
-        chorusFeedbackPercentSmoother,
-        chorusMixPercentSmoother,
-        overdriveSaturationSmoother,
-        ladderFilterCutoffHzSmoother,
-        ladderFilterResonanceSmoother,
-        ladderFilterDriveSmoother,
-        generalFilterFreqHzSmoother,
-        generalFilterQualitySmoother,
-        generalFilterGainSmoother,
-        inputGainSmoother,
-        outputGainSmoother;
+    /*
+        every smoothed float parameter, in the same order as the binding table built in the constructor.
+    */
+    enum SmoothedParam
+    {
+        PhaserRateHz,
+        PhaserCenterFreqHz,
+        PhaserDepthPercent,
+        PhaserFeedbackPercent,
+        PhaserMixPercent,
+        ChorusRateHz,
+        ChorusDepthPercent,
+        ChorusCenterDelayMs,
+        ChorusFeedbackPercent,
+        ChorusMixPercent,
+        OverdriveSaturation,
+        LadderFilterCutoffHz,
+        LadderFilterResonance,
+        LadderFilterDrive,
+        GeneralFilterFreqHz,
+        GeneralFilterQuality,
+        GeneralFilterGain,
+        DelayTimeMs,
+        DelayFeedbackPercent,
+        DelayLowCutHz,
+        DelayHighCutHz,
+        DelayModulationRateHz,
+        DelayModulationDepthMs,
+        DelayMixPercent,
+        NumSmoothedParams
+    };
+
+    SmootherBank<NumSmoothedParams> smoothers;
 
     juce::Atomic<bool> guiNeedsLatestDspOrder{ false };
     juce::Atomic<float> leftPreRMS, rightPreRMS, leftPostRMS, rightPostRMS;
+    juce::Atomic<float> leftPrePeak, rightPrePeak, leftPostPeak, rightPostPeak;
+    juce::Atomic<float> leftPreTruePeak, rightPreTruePeak, leftPostTruePeak, rightPostTruePeak;
 
     SimpleMBComp::SingleChannelSampleFifo<juce::AudioBuffer<float>> leftSCSF{ SimpleMBComp::Channel::Left }, rightSCSF{ SimpleMBComp::Channel::Right };
 
+    //largest bus accepted by isBusesLayoutSupported(). 16 channels fits 7.1.4 and 3rd order ambisonics.
+    static constexpr int maxNumChannels = 16;
+
 
     std::vector<juce::RangedAudioParameter*> getParamsForOption(DSP_Option option);
 
 private:
     DSP_Order dspOrder; // Create an object
-    juce::dsp::Gain<float> inputGainDSP, outputGainDSP;
-    
-    template<typename DSP> // class template, we can create versions for different DSP effect types
-    struct DSP_Choice : juce::dsp::ProcessorBase
-    {
-        void prepare(const juce::dsp::ProcessSpec& spec) override
-        {
-            dsp.prepare(spec);
-        }
-        void process(const juce::dsp::ProcessContextReplacing<float>& context) override
-        {
-            dsp.process(context);
-        }
-        void reset() override
-        {
-            dsp.reset();
-        }
 
-        DSP dsp;
+    template<typename SampleType>
+    struct ProcessingEngine
+    {
+        //gain and metering in one pass
+        MeteredGain<SampleType> inputGainDSP, outputGainDSP;
+
+        /*
+            one chain for every channel, or one per channel group when parallelProcessing is on.
+            per-sample work like the phaser/chorus modulation is shared instead of duplicated per channel.
+            a second copy of the chain is kept so a new dspOrder can be crossfaded in.
+        */
+        ParallelChain<SampleType> channelDSP;
     };
 
-    struct MonoChannelDSP
-    {
-        MonoChannelDSP(CAudioPluginAudioProcessor& proc) : p(proc) {}
-        DSP_Choice<juce::dsp::DelayLine<float>> delay;
-        DSP_Choice<juce::dsp::Phaser<float>> phaser;
-        DSP_Choice<juce::dsp::Chorus<float>> chorus;
-        DSP_Choice<juce::dsp::LadderFilter<float>> overdrive, ladderFilter;
-        DSP_Choice<juce::dsp::IIR::Filter<float>> generalFilter;
+    /*
+        one engine per processing precision, so a 64-bit host mix engine runs the chain in double without converting.
+        only the engine matching getProcessingPrecision() is prepared.
+    */
+    ProcessingEngine<float> floatEngine;
+    ProcessingEngine<double> doubleEngine;
 
-        void prepare(const juce::dsp::ProcessSpec& spec);
+    /*
+        helps the audio thread with large blocks. every instance in the process shares it.
+        nullptr unless parallelProcessing or offlineProfile is on.
+    */
+    std::shared_ptr<RealtimeWorkerPool> workerPool;
 
-        void updateDSPFromParams();
+    /*
+        picked in prepareToPlay from isNonRealtime().
+        offline renders skip the control-rate sub-blocks, run the overdrive at the highest oversampling quality,
+        and spread the channels over the shared worker pool unless offlineWorkerPoolEnabled is off.
+    */
+    bool offlineProfile = false;
+    bool offlineWorkerPoolEnabled = true;
 
-        void process(juce::dsp::AudioBlock<float> block, const DSP_Order& dspOrder);
+    //the last tempo the play head reported, for the synced delay time. audio thread only.
+    double hostBpm = 120.0;
 
-    private:
-        CAudioPluginAudioProcessor& p;
+    template<typename SampleType>
+    void prepareEngine(ProcessingEngine<SampleType>& engine, const juce::dsp::ProcessSpec& spec);
 
-        GeneralFilterMode filterMode = GeneralFilterMode::END_OF_LIST;
-        float filterFreq = 0.f, filterQ = 0.f, filterGain = -100.f;
-    };
+    //the spec of the last prepareToPlay, so the channels can be regrouped without the host.
+    juce::dsp::ProcessSpec preparedSpec{};
 
-    MonoChannelDSP leftChannel{ *this };
-    MonoChannelDSP rightChannel{ *this };
+    /*
+        the delay's ping-pong pairs can't be split over two channel groups, see ParallelChain.
+        true if the current ping-pong setting needs the channels grouped differently. message thread.
+    */
+    bool channelsNeedRegrouping() const;
+    void regroupChannels();
 
-    struct ProcessState
+    // reads the bypass parameters, on any thread.
+    DSP_Bypassed getBypassedStages() const;
+
+    //some hosts call prepareToPlay off the message thread, where it could meet timerCallback() preparing skipped stages.
+    juce::CriticalSection stagePreparationLock;
+
+    template<typename SampleType>
+    void processBlockWithEngine(juce::AudioBuffer<SampleType>& buffer, ProcessingEngine<SampleType>& engine);
+
+    template<typename SampleType>
+    void publishMeasurements(const MeteredGain<SampleType>& stage,
+                             juce::Atomic<float>& leftRMS, juce::Atomic<float>& rightRMS,
+                             juce::Atomic<float>& leftPeak, juce::Atomic<float>& rightPeak,
+                             juce::Atomic<float>& leftTruePeak, juce::Atomic<float>& rightTruePeak);
+
+    DSPParameters dspParameters;
+
+    template<typename SampleType>
+    void updateDSPFromParams(ProcessingEngine<SampleType>& engine);
+
+    /*
+        plain copy of every parameter value the audio thread reads.
+        parameterChanged() only flags a change. processBlock() publishes a new one when it sees the flag,
+        and acquires it once per block.
+    */
+    struct ParameterSnapshot
     {
-        juce::dsp::ProcessorBase* processor = nullptr;
-        bool bypassed = false;
+        std::array<float, NumSmoothedParams> smoothedTargets{};
+
+        int ladderFilterModeIndex = 0;
+        int generalFilterModeIndex = 0;
+        int overdriveOversamplingIndex = 0;
+        int overdriveOversamplingFilterIndex = 0;
+        int controlRateGranularityIndex = 0;
+
+        bool delaySync = false;
+        int delayNoteIndex = 0;
+        bool delayPingPong = false;
+        int delayInterpolationIndex = 0;
+
+        DSP_Bypassed bypassed{};
+
+        float inputGainDb = 0.f;
+        float outputGainDb = 0.f;
+        float reorderCrossfadeMs = 0.f;
+        bool parallelProcessing = false;
     };
 
-    using DSP_Pointers = std::array<ProcessState, static_cast<size_t>(DSP_Option::END_OF_LIST)>;
+    SnapshotChannel<ParameterSnapshot> parameterSnapshots;
+
+    //the snapshot acquired for the block being processed
+    const ParameterSnapshot* blockParameters = nullptr;
+
+    //set by any thread that changes a parameter, cleared by the audio thread when it publishes
+    std::atomic<bool> parametersChanged{ false };
+
+    void publishParameterSnapshot();
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+
+    //the analyzer fifos always see a stereo pair, whatever the bus layout is.
+    void updateAnalyzerFifos(const juce::AudioBuffer<float>& buffer);
+    void updateAnalyzerFifos(const juce::AudioBuffer<double>& buffer);
+    juce::AudioBuffer<float> analyzerBuffer;
 
-# define VERIFY_BYPASS_FUNCTIONALITY false
+    //the analyzer is float only. double blocks are converted into this, in chunks of up to its size.
+    juce::AudioBuffer<float> analyzerConversionBuffer;
+    std::array<float*, 2> analyzerChannels{};
+
+    SilenceDetector silenceDetector;
+    juce::Atomic<double> tailLengthSeconds{ 0.0 };
+
+    /*
+        the latency the chain has now. the audio thread only stores it,
+        timerCallback() hands it to setLatencySamples() on the message thread.
+    */
+    juce::Atomic<int> latencyInSamples{ 0 };
+    static constexpr int latencyPollRateHz = 10;
+
+    //also prepares the stages that were switched on since prepareToPlay, so one takes up to 1 / latencyPollRateHz to fade in.
+    void timerCallback() override;
 
     template<typename ParamType, typename Params, typename Funcs> 
     void initCachedParams(Params paramsArray, Funcs funcsArray)
@@ -235,7 +374,11 @@ private:
         }
     }
 
-    std::vector<juce::SmoothedValue<float>*> getSmoothers();
+    /*
+        parameter -> smoother binding table.
+        built once in the constructor so the audio thread never has to build a list of parameters.
+    */
+    std::array<juce::AudioParameterFloat*, NumSmoothedParams> smoothedParams{};
 
     enum class SmootherUpdateMode
     {
@@ -244,6 +387,10 @@ private:
     };
 
     void updateSmoothersFromParams(int numSamplesToSkip, SmootherUpdateMode init);
+    void retargetSmoothersFromParams(SmootherUpdateMode init);
+
+    //the benchmark suite times the per-sub-block helpers above directly
+    friend struct ProcessorBenchmarks;
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CAudioPluginAudioProcessor)
 };
@@ -0,0 +1,143 @@
+/*
+  ==============================================================================
+
+    CompensationDelayTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/DSP/CompensationDelay.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int maxBlockSize = 512;
+    constexpr int maxDelaySamples = 100;
+    constexpr int delaySamples = 37;
+
+    //sample n of the input is n + 1, so a sample out of place shows up
+    float getInput(int n)
+    {
+        return static_cast<float>(n + 1);
+    }
+
+    float getExpected(int n)
+    {
+        return n < delaySamples ? 0.f : getInput(n - delaySamples);
+    }
+}
+
+struct CompensationDelayTests : juce::UnitTest
+{
+    CompensationDelayTests() : juce::UnitTest("CompensationDelay", "DSP") {}
+
+    void runTest() override
+    {
+        const juce::dsp::ProcessSpec spec{ sampleRate, maxBlockSize, 2 };
+
+        //some blocks shorter than the delay, some longer than the whole line
+        const std::array<int, 6> blockSizes{ 64, 5, 300, 1, 512, 20 };
+
+        beginTest("the signal comes out the delay later");
+        {
+            CompensationDelay<float> delay;
+            delay.prepare(spec, maxDelaySamples);
+            delay.setDelay(delaySamples);
+
+            juce::AudioBuffer<float> buffer(2, maxBlockSize);
+            bool inTime = true;
+            int n = 0;
+
+            for (auto blockSize : blockSizes)
+            {
+                for (int ch = 0; ch < 2; ++ch)
+                    for (int i = 0; i < blockSize; ++i)
+                        buffer.setSample(ch, i, getInput(n + i));
+
+                delay.process(juce::dsp::AudioBlock<float>(buffer).getSubBlock(0, static_cast<size_t>(blockSize)));
+
+                for (int ch = 0; ch < 2; ++ch)
+                    for (int i = 0; i < blockSize; ++i)
+                        inTime &= buffer.getSample(ch, i) == getExpected(n + i);
+
+                n += blockSize;
+            }
+
+            expect(inTime);
+        }
+
+        //the stage runs while the input is pushed, then the delay takes over at the start of a fade
+        beginTest("what was pushed comes out in time once it takes over");
+        {
+            for (size_t firstProcessed = 1; firstProcessed < blockSizes.size(); ++firstProcessed)
+            {
+                CompensationDelay<float> delay;
+                delay.prepare(spec, maxDelaySamples);
+                delay.setDelay(delaySamples);
+
+                juce::AudioBuffer<float> buffer(2, maxBlockSize);
+                bool inTime = true;
+                int n = 0;
+
+                for (size_t b = 0; b < blockSizes.size(); ++b)
+                {
+                    const auto blockSize = blockSizes[b];
+                    for (int ch = 0; ch < 2; ++ch)
+                        for (int i = 0; i < blockSize; ++i)
+                            buffer.setSample(ch, i, getInput(n + i));
+
+                    auto block = juce::dsp::AudioBlock<float>(buffer).getSubBlock(0, static_cast<size_t>(blockSize));
+                    if (b < firstProcessed)
+                    {
+                        delay.push(block);
+                    }
+                    else
+                    {
+                        delay.process(block);
+
+                        for (int ch = 0; ch < 2; ++ch)
+                            for (int i = 0; i < blockSize; ++i)
+                                inTime &= buffer.getSample(ch, i) == getExpected(n + i);
+                    }
+
+                    n += blockSize;
+                }
+
+                expect(inTime);
+            }
+        }
+
+        beginTest("a copy carries on with the samples in flight");
+        {
+            CompensationDelay<float> original, copy;
+            for (auto* d : { &original, &copy })
+            {
+                d->prepare(spec, maxDelaySamples);
+                d->setDelay(delaySamples);
+            }
+
+            juce::AudioBuffer<float> buffer(2, maxBlockSize);
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < 20; ++i)
+                    buffer.setSample(ch, i, getInput(i));
+
+            original.push(juce::dsp::AudioBlock<float>(buffer).getSubBlock(0, 20));
+            copy.copyStateFrom(original);
+
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < 64; ++i)
+                    buffer.setSample(ch, i, getInput(20 + i));
+
+            copy.process(juce::dsp::AudioBlock<float>(buffer).getSubBlock(0, 64));
+
+            bool inTime = true;
+            for (int i = 0; i < 64; ++i)
+                inTime &= buffer.getSample(1, i) == getExpected(20 + i);
+
+            expect(inTime);
+        }
+    }
+};
+
+static CompensationDelayTests compensationDelayTests;
@@ -0,0 +1,235 @@
+/*
+  ==============================================================================
+
+    CrossfadingChainTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/DSP/CrossfadingChain.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 64;
+
+    /*
+        just the delay, echoing every 10 ms.
+        the bypassed overdrive still delays by its latency, so it isn't oversampled: nothing else moves the echoes.
+    */
+    DSPParameters getDelayParameters()
+    {
+        DSPParameters params;
+        params.bypassed.fill(true);
+        params.bypassed[static_cast<size_t>(DSP_Option::Delay)] = false;
+        params.overdriveOversampling = OverdriveOversampling::x1;
+
+        params.delayTimeMs = 10.f;
+        params.delayFeedbackPercent = 50.f;
+        params.delayMixPercent = 100.f;
+        return params;
+    }
+
+    DSP_Order getDefaultOrder()
+    {
+        DSP_Order order{};
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = static_cast<DSP_Option>(i);
+
+        return order;
+    }
+}
+
+struct CrossfadingChainTests : juce::UnitTest
+{
+    CrossfadingChainTests() : juce::UnitTest("CrossfadingChain", "DSP") {}
+
+    void runTest() override
+    {
+        const juce::dsp::ProcessSpec spec{ sampleRate, blockSize, 2 };
+        const auto params = getDelayParameters();
+
+        //the delay moves from the end of the chain to the front, the other stages are bypassed
+        const auto order = getDefaultOrder();
+        auto reordered = order;
+        std::rotate(reordered.rbegin(), reordered.rbegin() + 1, reordered.rend());
+
+        beginTest("a reorder carries the running state into the new order");
+        {
+            CrossfadingChain<float> reference, chain;
+            for (auto* c : { &reference, &chain })
+            {
+                c->prepare(spec, params.bypassed);
+                c->updateDSPFromParams(params);
+                c->reset();
+            }
+
+            const auto fadeLengthInSamples = static_cast<int>(std::round(sampleRate * CrossfadingChain<float>::defaultFadeLengthSeconds));
+            const auto reorderBlock = 3;
+            const auto firstBlockAfterFade = reorderBlock + (fadeLengthInSamples + blockSize - 1) / blockSize;
+
+            juce::AudioBuffer<float> expected(2, blockSize), actual(2, blockSize);
+            bool reorderStarted = false, identicalAfterFade = true;
+            float echoesAfterFade = 0.f, largestErrorDuringFade = 0.f;
+
+            for (int b = 0; b < firstBlockAfterFade + 20; ++b)
+            {
+                expected.clear();
+                actual.clear();
+                if (b == 0)
+                {
+                    expected.setSample(0, 0, 1.f);
+                    actual.setSample(0, 0, 1.f);
+                }
+
+                reference.updateDSPFromParams(params);
+                chain.updateDSPFromParams(params);
+                reference.process(juce::dsp::AudioBlock<float>(expected), order, params);
+                chain.process(juce::dsp::AudioBlock<float>(actual), b < reorderBlock ? order : reordered, params);
+
+                if (b == reorderBlock)
+                    reorderStarted = chain.isReordering();
+
+                /*
+                    with every other stage bypassed, both orders sound the same.
+                    the fade sums the same signal to itself, which a fade that isn't equal-gain would boost mid-way.
+                */
+                if (b < firstBlockAfterFade)
+                {
+                    for (int i = 0; i < blockSize; ++i)
+                        largestErrorDuringFade = juce::jmax(largestErrorDuringFade, std::abs(expected.getSample(0, i) - actual.getSample(0, i)));
+
+                    continue;
+                }
+
+                for (int i = 0; i < blockSize; ++i)
+                {
+                    identicalAfterFade &= expected.getSample(0, i) == actual.getSample(0, i);
+                    echoesAfterFade = juce::jmax(echoesAfterFade, std::abs(actual.getSample(0, i)));
+                }
+            }
+
+            expect(reorderStarted);
+            expect(! chain.isReordering());
+
+            //a chain that started from silence would have nothing left to echo
+            expectGreaterThan(echoesAfterFade, 0.01f);
+            expect(identicalAfterFade);
+            expectLessThan(largestErrorDuringFade, 1.0e-6f);
+        }
+
+        beginTest("an unchanged order never fades");
+        {
+            CrossfadingChain<float> chain;
+            chain.prepare(spec, params.bypassed);
+            chain.updateDSPFromParams(params);
+            chain.reset();
+
+            juce::AudioBuffer<float> buffer(2, blockSize);
+            bool reordering = false;
+            for (int b = 0; b < 10; ++b)
+            {
+                chain.process(juce::dsp::AudioBlock<float>(buffer), order, params);
+                reordering |= chain.isReordering();
+            }
+
+            expect(! reordering);
+        }
+
+        beginTest("realtime, a stage coming back from bypass is reset by the message thread");
+        {
+            CrossfadingChain<float> chain;
+            chain.setDefersStageResets(true);
+            chain.prepare(spec, params.bypassed);
+            chain.updateDSPFromParams(params);
+            chain.reset();
+
+            auto bypassed = params;
+            bypassed.bypassed[static_cast<size_t>(DSP_Option::Delay)] = true;
+
+            juce::AudioBuffer<float> buffer(2, blockSize);
+            auto processBlock = [&](const DSPParameters& p, float firstSample)
+            {
+                buffer.clear();
+                buffer.setSample(0, 0, firstSample);
+                chain.updateDSPFromParams(p);
+                chain.process(juce::dsp::AudioBlock<float>(buffer), order, p);
+            };
+
+            //echoes go round the line, then the delay is switched off before they have died away
+            for (int b = 0; b < 20; ++b)
+                processBlock(b < 12 ? params : bypassed, b == 0 ? 1.f : 0.f);
+
+            expect(! chain.prepareSkippedStages(bypassed.bypassed));
+
+            //switched back on, it stays bypassed until the message thread has reset it
+            processBlock(params, 1.f);
+            expectEquals(buffer.getSample(0, 0), 1.f);
+
+            expect(chain.prepareSkippedStages(params.bypassed));
+
+            //nothing of the old echoes is left in the line
+            float peak = 0.f;
+            for (int b = 0; b < 40; ++b)
+            {
+                processBlock(params, 0.f);
+                for (int i = 0; i < blockSize; ++i)
+                    peak = juce::jmax(peak, std::abs(buffer.getSample(0, i)));
+            }
+
+            expectEquals(peak, 0.f);
+
+            //and it echoes again
+            processBlock(params, 1.f);
+            for (int b = 0; b < 10; ++b)
+            {
+                processBlock(params, 0.f);
+                for (int i = 0; i < blockSize; ++i)
+                    peak = juce::jmax(peak, std::abs(buffer.getSample(0, i)));
+            }
+
+            expectGreaterThan(peak, 0.9f);
+        }
+
+        //the host compensates for one latency, so the chain has to add it whether the overdrive runs or not
+        beginTest("a bypassed overdrive delays by the latency it reports");
+        {
+            DSPParameters bypassed;
+            bypassed.bypassed.fill(true);
+            bypassed.overdriveOversampling = OverdriveOversampling::x4;
+            bypassed.overdriveFilterType = OverdriveFilterType::FIR;
+
+            auto active = bypassed;
+            active.bypassed[static_cast<size_t>(DSP_Option::OverDrive)] = false;
+
+            CrossfadingChain<float> chain;
+            chain.prepare(spec, bypassed.bypassed);
+            chain.updateDSPFromParams(bypassed);
+            chain.reset();
+
+            const auto latency = chain.getLatencyInSamples(bypassed);
+            expectEquals(latency, chain.getLatencyInSamples(active));
+
+            //the impulse comes out exactly latency samples later, and nothing else does
+            juce::AudioBuffer<float> buffer(2, blockSize);
+            bool onlyTheImpulse = true;
+            for (int b = 0; b < 16; ++b)
+            {
+                buffer.clear();
+                if (b == 0)
+                    buffer.setSample(0, 0, 1.f);
+
+                chain.updateDSPFromParams(bypassed);
+                chain.process(juce::dsp::AudioBlock<float>(buffer), order, bypassed);
+
+                for (int i = 0; i < blockSize; ++i)
+                    onlyTheImpulse &= buffer.getSample(0, i) == (b * blockSize + i == latency ? 1.f : 0.f);
+            }
+
+            expect(onlyTheImpulse);
+        }
+    }
+};
+
+static CrossfadingChainTests crossfadingChainTests;
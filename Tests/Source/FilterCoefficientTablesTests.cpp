@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    FilterCoefficientTablesTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/DSP/FilterCoefficientTables.h"
+
+struct FilterCoefficientTablesTests : juce::UnitTest
+{
+    FilterCoefficientTablesTests() : juce::UnitTest("FilterCoefficientTables", "DSP") {}
+
+    void runTest() override
+    {
+        beginTest("one set of tables per sample rate");
+        {
+            auto a = FilterCoefficientTables::getForSampleRate(48000.0);
+            auto b = FilterCoefficientTables::getForSampleRate(48000.0);
+            auto c = FilterCoefficientTables::getForSampleRate(96000.0);
+
+            expect(a == b);
+            expect(a != c);
+        }
+
+        //the header promises these, over the whole 10 Hz - 0.49 fs range
+        beginTest("cutoff lookups stay within the stated error");
+        for (auto sampleRate : { 44100.0, 48000.0, 96000.0, 192000.0 })
+        {
+            auto tables = FilterCoefficientTables::getForSampleRate(sampleRate);
+            const auto maxFrequency = sampleRate * 0.49;
+
+            double worstSVFError = 0.0, worstLadderError = 0.0;
+            for (auto f = 10.0; f <= maxFrequency; f *= 1.0001)
+            {
+                const auto w = juce::MathConstants<double>::pi * f / sampleRate;
+
+                const auto svf = std::tan(w);
+                const auto ladder = std::exp(-2.0 * w);
+
+                worstSVFError = juce::jmax(worstSVFError, std::abs(tables->getSVFGain(static_cast<float>(f)) - svf) / svf);
+                worstLadderError = juce::jmax(worstLadderError, std::abs(tables->getLadderCutoffTransform(static_cast<float>(f)) - ladder) / ladder);
+            }
+
+            expectLessThan(worstSVFError, 1.0e-4);
+            expectLessThan(worstLadderError, 1.0e-5);
+        }
+
+        beginTest("peak amplitudes follow 10^(dB / 40)");
+        {
+            auto tables = FilterCoefficientTables::getForSampleRate(48000.0);
+
+            for (auto gainDb = -48.f; gainDb <= 48.f; gainDb += 0.37f)
+            {
+                const auto expected = std::pow(10.f, gainDb / 40.f);
+                expectWithinAbsoluteError(tables->getPeakAmplitude(gainDb) / expected, 1.f, 1.0e-4f);
+            }
+        }
+    }
+};
+
+static FilterCoefficientTablesTests filterCoefficientTablesTests;
@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    GeneralFilterTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/DSP/GeneralFilter.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+
+    //rms of a sine through the filter, measured once the filter has settled
+    float getSineGain(GeneralFilter<float>& filter, float frequencyHz)
+    {
+        const auto w = juce::MathConstants<float>::twoPi * frequencyHz / static_cast<float>(sampleRate);
+        const auto numSettleSamples = static_cast<int>(sampleRate * 0.5);
+        const auto numMeasuredSamples = static_cast<int>(sampleRate * 0.5);
+
+        double inSquares = 0.0, outSquares = 0.0;
+        for (int i = 0; i < numSettleSamples + numMeasuredSamples; ++i)
+        {
+            const auto x = std::sin(w * static_cast<float>(i));
+            const auto y = filter.processSample(x);
+
+            if (i >= numSettleSamples)
+            {
+                inSquares += x * x;
+                outSquares += y * y;
+            }
+        }
+
+        return static_cast<float>(std::sqrt(outSquares / inSquares));
+    }
+}
+
+struct GeneralFilterTests : juce::UnitTest
+{
+    GeneralFilterTests() : juce::UnitTest("GeneralFilter", "DSP") {}
+
+    void runTest() override
+    {
+        const juce::dsp::ProcessSpec spec{ sampleRate, 64, 1 };
+
+        beginTest("a 0 dB peak passes the input unchanged");
+        {
+            GeneralFilter<float> filter;
+            filter.setParameters(GeneralFilterMode::Peak, 1000.f, 0.72f, 0.f);
+            filter.prepare(spec);
+
+            juce::Random random(1);
+            float maxError = 0.f;
+            for (int i = 0; i < 4800; ++i)
+            {
+                const auto x = random.nextFloat() * 2.f - 1.f;
+                maxError = juce::jmax(maxError, std::abs(filter.processSample(x) - x));
+            }
+
+            expectLessThan(maxError, 1.0e-5f);
+        }
+
+        beginTest("the bandpass passes its centre frequency and the notch removes it");
+        {
+            GeneralFilter<float> bandpass, notch;
+            bandpass.setParameters(GeneralFilterMode::Bandpass, 1000.f, 2.f, 0.f);
+            notch.setParameters(GeneralFilterMode::Notch, 1000.f, 2.f, 0.f);
+            bandpass.prepare(spec);
+            notch.prepare(spec);
+
+            expectWithinAbsoluteError(getSineGain(bandpass, 1000.f), 1.f, 0.001f);
+            expectLessThan(getSineGain(notch, 1000.f), 0.001f);
+        }
+
+        beginTest("a +12 dB peak boosts its centre frequency by 12 dB");
+        {
+            GeneralFilter<float> filter;
+            filter.setParameters(GeneralFilterMode::Peak, 2000.f, 1.f, 12.f);
+            filter.prepare(spec);
+
+            const auto gainDb = juce::Decibels::gainToDecibels(getSineGain(filter, 2000.f));
+            expectWithinAbsoluteError(gainDb, 12.f, 0.01f);
+        }
+
+        beginTest("a cutoff moved every sample glides without blowing up");
+        {
+            GeneralFilter<float> filter;
+            filter.setParameters(GeneralFilterMode::Peak, 100.f, 4.f, 12.f);
+            filter.prepare(spec);
+
+            //+12 dB can't take a full scale sine much past 4, the glide mustn't add to that
+            float peak = 0.f;
+            bool allFinite = true;
+            for (int i = 0; i < static_cast<int>(sampleRate); ++i)
+            {
+                const auto sweep = 0.5f + 0.5f * std::sin(juce::MathConstants<float>::twoPi * static_cast<float>(i) / 4800.f);
+                filter.setParameters(GeneralFilterMode::Peak, 100.f * std::pow(100.f, sweep), 4.f, 12.f);
+
+                const auto y = filter.processSample(std::sin(0.05f * static_cast<float>(i)));
+                allFinite &= std::isfinite(y);
+                peak = juce::jmax(peak, std::abs(y));
+            }
+
+            expect(allFinite);
+            expectLessThan(peak, 6.f);
+        }
+    }
+};
+
+static GeneralFilterTests generalFilterTests;
@@ -0,0 +1,29 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Runs the behaviour checks of the DSP engine. Every *Tests.cpp next to
+    this file registers its juce::UnitTest, all in the "DSP" category.
+
+        Tests
+
+    Exits with 1 if any check failed, so ctest and CI can run it as is.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+int main()
+{
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runTestsInCategory("DSP");
+
+    int numFailures = 0;
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        numFailures += runner.getResult(i)->failures;
+
+    return numFailures > 0 ? 1 : 0;
+}
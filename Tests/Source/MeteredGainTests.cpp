@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    MeteredGainTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/DSP/MeteredGain.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int maxBlockSize = 512;
+
+    void fillWithSine(juce::AudioBuffer<float>& buffer, float frequencyHz, float phase)
+    {
+        const auto w = juce::MathConstants<float>::twoPi * frequencyHz / static_cast<float>(sampleRate);
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample(ch, i, std::sin(w * static_cast<float>(i) + phase));
+    }
+
+    // runs buffer through gain in blocks of blockSize, starting blockOffset samples in.
+    void processInBlocks(MeteredGain<float>& gain, juce::AudioBuffer<float>& buffer, int blockOffset, int blockSize)
+    {
+        juce::dsp::AudioBlock<float> block(buffer);
+
+        for (auto start = static_cast<size_t>(blockOffset); start < block.getNumSamples(); start += static_cast<size_t>(blockSize))
+        {
+            auto subBlock = block.getSubBlock(start, juce::jmin(static_cast<size_t>(blockSize), block.getNumSamples() - start));
+            gain.process(juce::dsp::ProcessContextReplacing<float>(subBlock));
+        }
+    }
+}
+
+struct MeteredGainTests : juce::UnitTest
+{
+    MeteredGainTests() : juce::UnitTest("MeteredGain", "DSP") {}
+
+    void runTest() override
+    {
+        const juce::dsp::ProcessSpec spec{ sampleRate, static_cast<juce::uint32>(maxBlockSize), 2 };
+
+        beginTest("measures the gained signal");
+        {
+            MeteredGain<float> gain;
+            gain.setGainDecibels(-6.f);
+            gain.prepare(spec);
+
+            juce::AudioBuffer<float> buffer(2, 4800);
+            fillWithSine(buffer, 1000.f, 0.f);
+            processInBlocks(gain, buffer, 0, maxBlockSize);
+
+            const auto expectedPeak = juce::Decibels::decibelsToGain(-6.f);
+            const auto measurement = gain.getMeasurement(1);
+
+            expectWithinAbsoluteError(measurement.peak, expectedPeak, 1.0e-3f);
+            expectWithinAbsoluteError(measurement.rms, expectedPeak / std::sqrt(2.f), 1.0e-3f);
+            expectWithinAbsoluteError(buffer.getSample(0, 12), expectedPeak, 1.0e-5f);
+            expectEquals(gain.getPeak(1), measurement.peak);
+        }
+
+        //fs / 4 at 45 degrees: every sample is at 0.707, the peaks fall between them
+        beginTest("the true peak finds the peaks between samples");
+        {
+            MeteredGain<float> gain;
+            gain.prepare(spec);
+
+            juce::AudioBuffer<float> buffer(2, 4800);
+            fillWithSine(buffer, static_cast<float>(sampleRate / 4.0), juce::MathConstants<float>::pi / 4.f);
+            processInBlocks(gain, buffer, 0, 100);
+
+            const auto measurement = gain.getMeasurement(0);
+            expectWithinAbsoluteError(measurement.peak, std::sqrt(0.5f), 1.0e-3f);
+            expectWithinAbsoluteError(measurement.truePeak, 1.f, 0.02f);
+        }
+
+        beginTest("a ramp doesn't depend on the block size or alignment");
+        {
+            juce::AudioBuffer<float> reference(2, 4096), split(2, 4097);
+            juce::Random random(7);
+            for (int i = 0; i < reference.getNumSamples(); ++i)
+            {
+                const auto x = random.nextFloat() * 2.f - 1.f;
+                for (int ch = 0; ch < 2; ++ch)
+                {
+                    reference.setSample(ch, i, x);
+                    split.setSample(ch, i + 1, x);
+                }
+            }
+
+            MeteredGain<float> a, b;
+            for (auto* gain : { &a, &b })
+            {
+                gain->prepare(spec);
+                gain->setGainDecibels(-12.f);
+            }
+
+            processInBlocks(a, reference, 0, maxBlockSize);
+            processInBlocks(b, split, 1, 37);
+
+            bool identical = true;
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < reference.getNumSamples(); ++i)
+                    identical &= reference.getSample(ch, i) == split.getSample(ch, i + 1);
+
+            expect(identical);
+            expectEquals(a.getMeasurement(0).peak, b.getMeasurement(0).peak);
+        }
+    }
+};
+
+static MeteredGainTests meteredGainTests;
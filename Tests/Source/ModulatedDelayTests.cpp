@@ -0,0 +1,146 @@
+/*
+  ==============================================================================
+
+    ModulatedDelayTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/DSP/ModulatedDelay.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    // wet only, with the feedback filters opened up as far as they go.
+    void prepareForEchoes(ModulatedDelay<float>& delay, int numChannels, float delayMs, bool pingPong)
+    {
+        delay.prepare({ sampleRate, blockSize, static_cast<juce::uint32>(numChannels) });
+        delay.setDelayTime(delayMs);
+        delay.setFeedback(0.5f);
+        delay.setFeedbackFilter(1.f, 24000.f);
+        delay.setMix(1.f);
+        delay.setPingPong(pingPong);
+
+        //snaps the glides to the settings above
+        delay.reset();
+    }
+
+    // an impulse on the first channel, then silence.
+    juce::AudioBuffer<float> getImpulseResponse(ModulatedDelay<float>& delay, int numChannels, int numSamples)
+    {
+        juce::AudioBuffer<float> buffer(numChannels, numSamples);
+        buffer.clear();
+        buffer.setSample(0, 0, 1.f);
+
+        juce::dsp::AudioBlock<float> block(buffer);
+        for (size_t start = 0; start < block.getNumSamples(); start += blockSize)
+        {
+            auto subBlock = block.getSubBlock(start, juce::jmin(static_cast<size_t>(blockSize), block.getNumSamples() - start));
+            delay.process(juce::dsp::ProcessContextReplacing<float>(subBlock));
+        }
+
+        return buffer;
+    }
+
+    float getPeak(const juce::AudioBuffer<float>& buffer, int channel, int start, int end)
+    {
+        float peak = 0.f;
+        for (int i = start; i < end; ++i)
+            peak = juce::jmax(peak, std::abs(buffer.getSample(channel, i)));
+
+        return peak;
+    }
+}
+
+struct ModulatedDelayTests : juce::UnitTest
+{
+    ModulatedDelayTests() : juce::UnitTest("ModulatedDelay", "DSP") {}
+
+    void runTest() override
+    {
+        beginTest("echoes arrive after the delay time and fade with the feedback");
+        {
+            ModulatedDelay<float> delay;
+            prepareForEchoes(delay, 1, 10.f, false);
+            const auto response = getImpulseResponse(delay, 1, 2048);
+
+            expectEquals(getPeak(response, 0, 0, 480), 0.f);
+            expectWithinAbsoluteError(response.getSample(0, 480), 1.f, 1.0e-4f);
+            expectEquals(getPeak(response, 0, 481, 950), 0.f);
+
+            const auto secondEcho = getPeak(response, 0, 950, 1000);
+            expectGreaterThan(secondEcho, 0.4f);
+            expectLessThan(secondEcho, 0.5f);
+        }
+
+        beginTest("ping-pong bounces the echoes between the pair");
+        {
+            ModulatedDelay<float> delay;
+            prepareForEchoes(delay, 2, 10.f, true);
+            const auto response = getImpulseResponse(delay, 2, 2048);
+
+            //left, right, left
+            expectGreaterThan(getPeak(response, 0, 470, 500), 0.9f);
+            expectEquals(getPeak(response, 1, 0, 950), 0.f);
+            expectGreaterThan(getPeak(response, 1, 950, 1000), 0.4f);
+            expectLessThan(getPeak(response, 0, 950, 1000), 1.0e-3f);
+            expectGreaterThan(getPeak(response, 0, 1430, 1480), 0.2f);
+        }
+
+        beginTest("the line holds the longest synced note");
+        {
+            //4 beats at 30 bpm
+            const auto longestNoteMs = 60000.f / 30.f * 4.f;
+
+            ModulatedDelay<float> delay;
+            prepareForEchoes(delay, 1, longestNoteMs, false);
+
+            const auto delaySamples = static_cast<int>(longestNoteMs * 0.001 * sampleRate);
+            const auto response = getImpulseResponse(delay, 1, delaySamples + blockSize);
+
+            expectEquals(getPeak(response, 0, 0, delaySamples), 0.f);
+            expectWithinAbsoluteError(response.getSample(0, delaySamples), 1.f, 1.0e-4f);
+        }
+
+        beginTest("a copy carries on with the echoes in flight");
+        {
+            ModulatedDelay<float> original, copy;
+            prepareForEchoes(original, 1, 10.f, false);
+            prepareForEchoes(copy, 1, 10.f, false);
+
+            //the copy's line is full of something else, which the echoes in flight have to replace
+            juce::AudioBuffer<float> noise(1, 4096);
+            juce::Random random(5);
+            for (int i = 0; i < noise.getNumSamples(); ++i)
+                noise.setSample(0, i, random.nextFloat() * 2.f - 1.f);
+
+            juce::dsp::AudioBlock<float> noiseBlock(noise);
+            copy.process(juce::dsp::ProcessContextReplacing<float>(noiseBlock));
+
+            //the impulse goes in, then the copy takes over before its echo comes out.
+            //the write position is still near the start, so the window wraps round the end of the line.
+            getImpulseResponse(original, 1, 256);
+            copy.copyStateFrom(original);
+
+            juce::AudioBuffer<float> fromOriginal(1, blockSize), fromCopy(1, blockSize);
+            fromOriginal.clear();
+            fromCopy.clear();
+
+            juce::dsp::AudioBlock<float> originalBlock(fromOriginal), copyBlock(fromCopy);
+            original.process(juce::dsp::ProcessContextReplacing<float>(originalBlock));
+            copy.process(juce::dsp::ProcessContextReplacing<float>(copyBlock));
+
+            bool identical = true;
+            for (int i = 0; i < blockSize; ++i)
+                identical &= fromOriginal.getSample(0, i) == fromCopy.getSample(0, i);
+
+            expect(identical);
+            expectWithinAbsoluteError(fromCopy.getSample(0, 480 - 256), 1.f, 1.0e-4f);
+        }
+    }
+};
+
+static ModulatedDelayTests modulatedDelayTests;
@@ -0,0 +1,151 @@
+/*
+  ==============================================================================
+
+    ParallelChainTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/DSP/ParallelChain.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    constexpr int numChannels = 4;
+
+    DSP_Order getDefaultOrder()
+    {
+        DSP_Order order{};
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = static_cast<DSP_Option>(i);
+
+        return order;
+    }
+
+    // the general filter into the delay, both with state that carries across blocks.
+    DSPParameters getFilterAndDelayParameters()
+    {
+        DSPParameters params;
+        params.bypassed.fill(true);
+        params.bypassed[static_cast<size_t>(DSP_Option::GeneralFilter)] = false;
+        params.bypassed[static_cast<size_t>(DSP_Option::Delay)] = false;
+
+        params.generalFilterFreqHz = 1000.f;
+        params.generalFilterGainDb = 6.f;
+
+        params.delayTimeMs = 7.f;
+        params.delayFeedbackPercent = 40.f;
+        params.delayMixPercent = 50.f;
+        return params;
+    }
+
+    void fillWithNoise(juce::AudioBuffer<float>& buffer, juce::Random& random)
+    {
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample(ch, i, random.nextFloat() * 2.f - 1.f);
+    }
+}
+
+struct ParallelChainTests : juce::UnitTest
+{
+    ParallelChainTests() : juce::UnitTest("ParallelChain", "DSP") {}
+
+    void runTest() override
+    {
+        const juce::dsp::ProcessSpec spec{ sampleRate, blockSize, numChannels };
+        const auto params = getFilterAndDelayParameters();
+        const auto order = getDefaultOrder();
+
+        beginTest("the output doesn't depend on whether the groups ran in parallel");
+        {
+            RealtimeWorkerPool pool;
+            pool.start(3);
+
+            ParallelChain<float> serial, parallel;
+            for (auto* chain : { &serial, &parallel })
+            {
+                chain->prepare(spec, numChannels, params.bypassed, false);
+                chain->updateDSPFromParams(params);
+                chain->reset();
+            }
+
+            expectEquals(parallel.getNumGroups(), numChannels);
+
+            juce::Random random(3);
+            juce::AudioBuffer<float> input(numChannels, blockSize), expected(numChannels, blockSize), actual(numChannels, blockSize);
+            bool identical = true, processed = false;
+
+            for (int b = 0; b < 50; ++b)
+            {
+                fillWithNoise(input, random);
+                for (int ch = 0; ch < numChannels; ++ch)
+                    for (int i = 0; i < blockSize; ++i)
+                    {
+                        expected.setSample(ch, i, input.getSample(ch, i));
+                        actual.setSample(ch, i, input.getSample(ch, i));
+                    }
+
+                serial.updateDSPFromParams(params);
+                parallel.updateDSPFromParams(params);
+                serial.process(juce::dsp::AudioBlock<float>(expected), order, params, nullptr);
+                parallel.process(juce::dsp::AudioBlock<float>(actual), order, params, &pool);
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                    for (int i = 0; i < blockSize; ++i)
+                    {
+                        identical &= expected.getSample(ch, i) == actual.getSample(ch, i);
+                        processed |= actual.getSample(ch, i) != input.getSample(ch, i);
+                    }
+            }
+
+            expect(processed);
+            expect(identical);
+            pool.stop();
+        }
+
+        //a ping-pong pair feeds each other sample by sample, so it can't be split over two groups
+        beginTest("ping-pong keeps each channel pair in one group");
+        {
+            const juce::dsp::ProcessSpec stereo{ sampleRate, blockSize, 2 };
+
+            auto pingPong = params;
+            pingPong.bypassed[static_cast<size_t>(DSP_Option::GeneralFilter)] = true;
+            pingPong.delayTimeMs = 5.f;
+            pingPong.delayMixPercent = 100.f;
+            pingPong.delayPingPong = true;
+
+            ParallelChain<float> chain;
+            chain.prepare(stereo, 2, pingPong.bypassed, false);
+            expectEquals(chain.getNumGroups(), 2);
+            expect(! chain.isGroupedFor(true));
+
+            chain.prepare(stereo, 2, pingPong.bypassed, true);
+            expectEquals(chain.getNumGroups(), 1);
+            expect(chain.isGroupedFor(true));
+
+            RealtimeWorkerPool pool;
+            pool.start(1);
+
+            chain.updateDSPFromParams(pingPong);
+            chain.reset();
+
+            juce::AudioBuffer<float> buffer(2, blockSize);
+            buffer.clear();
+            buffer.setSample(0, 0, 1.f);
+            chain.process(juce::dsp::AudioBlock<float>(buffer), order, pingPong, &pool);
+
+            //the second echo comes back on the right
+            float rightPeak = 0.f;
+            for (int i = 0; i < blockSize; ++i)
+                rightPeak = juce::jmax(rightPeak, std::abs(buffer.getSample(1, i)));
+
+            expectGreaterThan(rightPeak, 0.1f);
+            pool.stop();
+        }
+    }
+};
+
+static ParallelChainTests parallelChainTests;
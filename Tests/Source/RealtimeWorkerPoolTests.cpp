@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    RealtimeWorkerPoolTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/DSP/RealtimeWorkerPool.h"
+
+#include <thread>
+
+namespace
+{
+    constexpr int numJobs = 8;
+
+    struct JobCounts
+    {
+        std::array<std::atomic<int>, numJobs> counts{};
+        std::atomic<int> numOnOtherThreads{ 0 };
+        std::thread::id caller = std::this_thread::get_id();
+    };
+
+    void countJob(void* context, int jobIndex)
+    {
+        auto& jobs = *static_cast<JobCounts*>(context);
+        ++jobs.counts[static_cast<size_t>(jobIndex)];
+
+        if (std::this_thread::get_id() != jobs.caller)
+            ++jobs.numOnOtherThreads;
+    }
+
+    // runs numBatches batches and returns true if every job of every batch ran exactly once.
+    bool runBatches(RealtimeWorkerPool& pool, int numBatches, JobCounts& jobs)
+    {
+        bool allRanOnce = true;
+
+        for (int b = 0; b < numBatches; ++b)
+        {
+            for (auto& count : jobs.counts)
+                count = 0;
+
+            pool.run(numJobs, &countJob, &jobs);
+
+            for (auto& count : jobs.counts)
+                allRanOnce &= count == 1;
+        }
+
+        return allRanOnce;
+    }
+}
+
+struct RealtimeWorkerPoolTests : juce::UnitTest
+{
+    RealtimeWorkerPoolTests() : juce::UnitTest("RealtimeWorkerPool", "DSP") {}
+
+    void runTest() override
+    {
+        beginTest("every job of a batch runs exactly once");
+        {
+            RealtimeWorkerPool pool;
+            pool.start(3);
+            expectEquals(pool.getNumWorkers(), 3);
+
+            JobCounts jobs;
+            expect(runBatches(pool, 10000, jobs));
+            pool.stop();
+        }
+
+        beginTest("without workers every job runs on the calling thread");
+        {
+            RealtimeWorkerPool pool;
+            pool.start(0);
+
+            JobCounts jobs;
+            expect(runBatches(pool, 10, jobs));
+            expectEquals(jobs.numOnOtherThreads.load(), 0);
+        }
+
+        //the second caller finds the pool busy and runs its batch itself
+        beginTest("two threads can run batches on one pool at once");
+        {
+            RealtimeWorkerPool pool;
+            pool.start(3);
+
+            JobCounts jobsA, jobsB;
+            bool allRanOnceA = false, allRanOnceB = false;
+
+            std::thread other([&]
+            {
+                jobsB.caller = std::this_thread::get_id();
+                allRanOnceB = runBatches(pool, 10000, jobsB);
+            });
+
+            allRanOnceA = runBatches(pool, 10000, jobsA);
+            other.join();
+
+            expect(allRanOnceA);
+            expect(allRanOnceB);
+            pool.stop();
+        }
+
+        beginTest("instances share one pool while any of them holds it");
+        {
+            auto a = RealtimeWorkerPool::getShared();
+            auto b = RealtimeWorkerPool::getShared();
+            expect(a != nullptr);
+            expect(a == b);
+            expectEquals(a->getNumWorkers(), RealtimeWorkerPool::getDefaultNumWorkers());
+        }
+    }
+};
+
+static RealtimeWorkerPoolTests realtimeWorkerPoolTests;
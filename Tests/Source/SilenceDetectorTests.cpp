@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    SilenceDetectorTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/DSP/SilenceDetector.h"
+
+struct SilenceDetectorTests : juce::UnitTest
+{
+    SilenceDetectorTests() : juce::UnitTest("SilenceDetector", "DSP") {}
+
+    void runTest() override
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int subBlockSize = 64;
+
+        beginTest("the chain only sleeps once the tail is over");
+        {
+            SilenceDetector detector;
+            detector.prepare(sampleRate);
+
+            //a 10 ms tail is 480 samples, which the first 8 silent sub-blocks still cover
+            constexpr double tailLengthSeconds = 0.01;
+            int numAwake = 0;
+            for (int b = 0; b < 20; ++b)
+                if (! detector.update(true, subBlockSize, tailLengthSeconds))
+                    ++numAwake;
+
+            expectEquals(numAwake, 8);
+            expect(detector.isAsleep());
+
+            expect(! detector.update(false, subBlockSize, tailLengthSeconds));
+            expect(! detector.isAsleep());
+        }
+
+        beginTest("silence is read from the input gain's meter");
+        {
+            MeteredGain<float> inputGain;
+            inputGain.prepare({ sampleRate, subBlockSize, 2 });
+
+            juce::AudioBuffer<float> buffer(2, subBlockSize);
+            buffer.clear();
+            juce::dsp::AudioBlock<float> block(buffer);
+
+            inputGain.process(juce::dsp::ProcessContextReplacing<float>(block));
+            expect(SilenceDetector::isSilent(inputGain, 2));
+
+            //anything above -120 dBFS on any channel is sound
+            buffer.setSample(1, 10, 1.0e-5f);
+            inputGain.startMeasurement();
+            inputGain.process(juce::dsp::ProcessContextReplacing<float>(block));
+            expect(! SilenceDetector::isSilent(inputGain, 2));
+            expect(SilenceDetector::isSilent(inputGain, 1));
+        }
+    }
+};
+
+static SilenceDetectorTests silenceDetectorTests;
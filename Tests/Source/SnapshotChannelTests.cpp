@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    SnapshotChannelTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/DSP/SnapshotChannel.h"
+
+#include <thread>
+
+namespace
+{
+    //the writer keeps every field equal, so a snapshot that mixes two publishes shows up
+    struct TestSnapshot
+    {
+        std::array<juce::int64, 32> values{};
+    };
+}
+
+struct SnapshotChannelTests : juce::UnitTest
+{
+    SnapshotChannelTests() : juce::UnitTest("SnapshotChannel", "DSP") {}
+
+    void runTest() override
+    {
+        beginTest("acquire returns the latest publish");
+        {
+            SnapshotChannel<TestSnapshot> channel;
+            expectEquals(channel.acquire().values[0], juce::int64(0));
+            expectEquals(channel.getAcquiredVersion(), juce::uint64(0));
+
+            for (juce::int64 n = 1; n <= 3; ++n)
+                channel.publish([n](TestSnapshot& s) { s.values.fill(n); });
+
+            expectEquals(channel.acquire().values[0], juce::int64(3));
+            expectEquals(channel.getAcquiredVersion(), juce::uint64(3));
+
+            //nothing new, the same snapshot again
+            expectEquals(channel.acquire().values[31], juce::int64(3));
+            expectEquals(channel.getAcquiredVersion(), juce::uint64(3));
+        }
+
+        beginTest("a reader never sees a torn or older snapshot");
+        {
+            SnapshotChannel<TestSnapshot> channel;
+            static constexpr juce::int64 numPublishes = 200000;
+
+            std::thread writer([&channel]
+            {
+                for (juce::int64 n = 1; n <= numPublishes; ++n)
+                    channel.publish([n](TestSnapshot& s) { s.values.fill(n); });
+            });
+
+            bool consistent = true, inOrder = true;
+            juce::int64 last = 0;
+
+            while (last < numPublishes)
+            {
+                const auto& snapshot = channel.acquire();
+                const auto n = snapshot.values[0];
+
+                for (auto v : snapshot.values)
+                    consistent &= v == n;
+
+                inOrder &= n >= last && channel.getAcquiredVersion() == static_cast<juce::uint64>(n);
+                last = n;
+            }
+
+            writer.join();
+
+            expect(consistent);
+            expect(inOrder);
+        }
+    }
+};
+
+static SnapshotChannelTests snapshotChannelTests;